@@ -161,6 +161,25 @@ class AString
 	size_t size() const
 	{ return len; }
 
+	// keeps the old content and size if the allocation fails
+	void resize(size_t s)
+	{
+		char *n = (char *) realloc(str,s+1);
+		if (n == 0)
+			return;
+		str = n;
+		if (s > len)
+			memset(str+len,0,s-len);
+		str[s] = 0;
+		len = s;
+	}
+
+	char &operator [] (size_t x)
+	{ return str[x]; }
+
+	char operator [] (size_t x) const
+	{ return str[x]; }
+
 	friend bool operator < (const AString &, const AString &);
 	friend bool operator <= (const AString &, const AString &);
 	friend bool operator > (const AString &, const AString &);
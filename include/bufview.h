@@ -0,0 +1,99 @@
+/*
+ *  Copyright (C) 2026, Thomas Maier-Komor
+ *
+ *  This source file belongs to Wire-Format-Compiler.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BUFVIEW_H
+#define _BUFVIEW_H
+
+#include <string.h>
+
+// BufView: implementation for stringtype=view and bytestype=view
+// - pointer/length pair referring to data owned by someone else
+// - fromMemory assigns the location of the payload within the buffer
+//   that is being parsed, i.e. no data is copied
+// - lifetime: the referenced memory must stay valid and unmodified as
+//   long as the view or the message containing it is in use
+// - the data is not \0 terminated, use data() and size()
+
+class BufView
+{
+	public:
+	BufView()
+	: str(0)
+	, len(0)
+	{ }
+
+	BufView(const char *d)
+	: str(d)
+	, len(d ? strlen(d) : 0)
+	{ }
+
+	BufView(const char *d, size_t l)
+	: str(d)
+	, len(l)
+	{ }
+
+	void assign(const char *d)
+	{
+		str = d;
+		len = d ? strlen(d) : 0;
+	}
+
+	void assign(const char *d, size_t l)
+	{
+		str = d;
+		len = l;
+	}
+
+	const char *data() const
+	{ return str; }
+
+	bool empty() const
+	{ return (len == 0); }
+
+	size_t size() const
+	{ return len; }
+
+	void clear()
+	{ str = 0; len = 0; }
+
+	bool operator == (const BufView &r) const
+	{ return (len == r.len) && ((len == 0) || (0 == memcmp(str,r.str,len))); }
+
+	bool operator != (const BufView &r) const
+	{ return !(*this == r); }
+
+	bool operator == (const char *r) const
+	{ return (len == strlen(r)) && ((len == 0) || (0 == memcmp(str,r,len))); }
+
+	bool operator != (const char *r) const
+	{ return !(*this == r); }
+
+	BufView &operator = (const char *s)
+	{
+		assign(s);
+		return *this;
+	}
+
+	private:
+	const char *str;
+	size_t len;
+};
+
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (C) 2026, Thomas Maier-Komor
+ *
+ *  This source file belongs to Wire-Format-Compiler.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FIELDMASK_H
+#define _FIELDMASK_H
+
+#include <stdint.h>
+#include <initializer_list>
+#include <vector>
+
+// FieldMask: set of field ids for fromMemory with option FieldMask
+// - fields of the message with an id in the set are decoded
+// - all other fields are skipped without being decoded
+// - ids select fields of the parsed message only, selected embedded
+//   messages are decoded completely
+
+class FieldMask
+{
+	public:
+	FieldMask()
+	{ }
+
+	FieldMask(std::initializer_list<unsigned> ids)
+	{
+		for (unsigned id : ids)
+			set(id);
+	}
+
+	void set(unsigned id)
+	{
+		unsigned x = id >> 3;
+		if (x >= bits.size())
+			bits.resize(x+1);
+		bits[x] |= 1 << (id & 7);
+	}
+
+	void clear(unsigned id)
+	{
+		unsigned x = id >> 3;
+		if (x < bits.size())
+			bits[x] &= ~(1 << (id & 7));
+	}
+
+	void clear()
+	{ bits.clear(); }
+
+	bool isSet(unsigned id) const
+	{
+		unsigned x = id >> 3;
+		return (x < bits.size()) && (bits[x] & (1 << (id & 7)));
+	}
+
+	private:
+	std::vector<uint8_t> bits;
+};
+
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ *  Copyright (C) 2017-2021, Thomas Maier-Komor
+ *
+ *  This source file belongs to Wire-Format-Compiler.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _IOVECBUILDER_H
+#define _IOVECBUILDER_H
+
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+
+/*
+ * Collects the serialized data of a message as an array of iovec
+ * entries for writev/sendmsg. Tags, lengths, and scalar values are
+ * encoded to the arena. Payloads of at least 'threshold' bytes are
+ * referenced in place, smaller ones are copied to the arena.
+ */
+class IovecBuilder
+{
+	public:
+	IovecBuilder(struct iovec *iov, unsigned niov, uint8_t *arena, size_t asize, size_t threshold = 256)
+	: m_iov(iov)
+	, m_arena(arena)
+	, m_at(arena)
+	, m_end(arena+asize)
+	, m_size(0)
+	, m_threshold(threshold)
+	, m_num(0)
+	, m_max(niov)
+	, m_open(false)
+	{ }
+
+	// returns the arena position for writing up to n bytes or 0
+	uint8_t *reserve(size_t n)
+	{
+		if ((m_at+n > m_end) || (!m_open && (m_num == m_max)))
+			return 0;
+		return m_at;
+	}
+
+	// append the arena data up to a, that was reserved before
+	void commit(uint8_t *a)
+	{
+		size_t n = a - m_at;
+		if (n == 0)
+			return;
+		if (m_open) {
+			m_iov[m_num-1].iov_len += n;
+		} else {
+			m_iov[m_num].iov_base = m_at;
+			m_iov[m_num].iov_len = n;
+			++m_num;
+			m_open = true;
+		}
+		m_at = a;
+		m_size += n;
+	}
+
+	// append n bytes at d, returns false if out of resources
+	bool add(const void *d, size_t n)
+	{
+		if (n == 0)
+			return true;
+		if (n < m_threshold) {
+			if (uint8_t *a = reserve(n)) {
+				memcpy(a,d,n);
+				commit(a+n);
+				return true;
+			}
+		}
+		if (m_num == m_max)
+			return false;
+		m_iov[m_num].iov_base = (void *)d;
+		m_iov[m_num].iov_len = n;
+		++m_num;
+		m_open = false;
+		m_size += n;
+		return true;
+	}
+
+	void clear()
+	{
+		m_at = m_arena;
+		m_size = 0;
+		m_num = 0;
+		m_open = false;
+	}
+
+	const struct iovec *getIovec() const
+	{ return m_iov; }
+
+	unsigned numIovec() const
+	{ return m_num; }
+
+	size_t getSize() const
+	{ return m_size; }
+
+	private:
+	struct iovec *m_iov;
+	uint8_t *m_arena, *m_at, *m_end;
+	size_t m_size, m_threshold;
+	unsigned m_num, m_max;
+	bool m_open;
+};
+
+
+#endif
@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/types.h>
 
 class Sink
@@ -221,4 +222,259 @@ class SinkString : public Sink
 #endif // WITH_SINK_STRING
 
 
+// BufferedSink: stages the serialized data in a buffer of N bytes and
+// passes it to Derived::flush(const uint8_t *, size_t) in blocks.
+// - values are stored inline, Derived::flush is called once per block
+// - data of sink_bytes that does not fit is passed through directly
+//   via Derived::flush(buffered, n, data, m), which may be overloaded
+//   to write both in one call
+// - Derived must call flushBuffer() before it is destroyed
+// - not copyable, as at points into buf
+template <class Derived, size_t N = 256>
+class BufferedSink : public Sink
+{
+	static_assert(N >= 10, "buffer must fit a varint");
+
+	public:
+	BufferedSink()
+	: at(buf)
+	{ }
+
+	BufferedSink(const BufferedSink &) = delete;
+	BufferedSink &operator = (const BufferedSink &) = delete;
+
+	void sink_vi(uint64_t v) final
+	{
+		if ((buf+N-at) < 10)
+			flushBuffer();
+		while (v >= 0x80) {
+			*at++ = (v & 0x7f) | 0x80;
+			v >>= 7;
+		}
+		*at++ = v;
+	}
+
+	void sink8(uint8_t u8) final
+	{
+		if (at == buf+N)
+			flushBuffer();
+		*at++ = u8;
+	}
+
+	void sink16(uint16_t v) final
+	{
+		if ((buf+N-at) < 2)
+			flushBuffer();
+		at[0] = v & 0xff;
+		at[1] = v >> 8;
+		at += 2;
+	}
+
+	void sink32(uint32_t v) final
+	{
+		if ((buf+N-at) < 4)
+			flushBuffer();
+		for (unsigned i = 0; i < 4; ++i) {
+			*at++ = v & 0xff;
+			v >>= 8;
+		}
+	}
+
+	void sink64(uint64_t v) final
+	{
+		if ((buf+N-at) < 8)
+			flushBuffer();
+		for (unsigned i = 0; i < 8; ++i) {
+			*at++ = v & 0xff;
+			v >>= 8;
+		}
+	}
+
+	void sink_bytes(const uint8_t *b, size_t n) final
+	{
+		if (n <= (size_t)(buf+N-at)) {
+			memcpy(at,b,n);
+			at += n;
+		} else if (n < N) {
+			flushBuffer();
+			memcpy(at,b,n);
+			at += n;
+		} else {
+			static_cast<Derived*>(this)->flush(buf,at-buf,b,n);
+			at = buf;
+		}
+	}
+
+	void flushBuffer()
+	{
+		if (at != buf) {
+			static_cast<Derived*>(this)->flush(buf,at-buf);
+			at = buf;
+		}
+	}
+
+	void flush(const uint8_t *b0, size_t n0, const uint8_t *b1, size_t n1)
+	{
+		if (n0)
+			static_cast<Derived*>(this)->flush(b0,n0);
+		static_cast<Derived*>(this)->flush(b1,n1);
+	}
+
+	private:
+	uint8_t buf[N], *at;
+};
+
+
+// BufferedSinkMem: appends to a buffer that grows as needed
+template <size_t N = 256>
+class BufferedSinkMem : public BufferedSink<BufferedSinkMem<N>,N>
+{
+	uint8_t *data;
+	size_t size, cap;
+
+	public:
+	BufferedSinkMem()
+	: data(0)
+	, size(0)
+	, cap(0)
+	{ }
+
+	~BufferedSinkMem()
+	{
+		free(data);
+	}
+
+	using BufferedSink<BufferedSinkMem<N>,N>::flush;
+
+	void flush(const uint8_t *b, size_t n)
+	{
+		if (size + n > cap) {
+			size_t c = cap ? cap : N;
+			while (c < size + n)
+				c <<= 1;
+			uint8_t *d = (uint8_t *) realloc(data,c);
+			if (d == 0)
+				abort();
+			data = d;
+			cap = c;
+		}
+		memcpy(data+size,b,n);
+		size += n;
+	}
+
+	// flushes the staged data
+	const uint8_t *getBuffer()
+	{
+		this->flushBuffer();
+		return data;
+	}
+
+	ssize_t getSize()
+	{
+		this->flushBuffer();
+		return size;
+	}
+
+	void clear()
+	{
+		this->flushBuffer();
+		size = 0;
+	}
+};
+
+
+#ifdef WITH_SINK_STRING
+// BufferedSinkString: appends to a std::string on flush
+template <size_t N = 256>
+class BufferedSinkString : public BufferedSink<BufferedSinkString<N>,N>
+{
+	std::string &str;
+
+	public:
+	BufferedSinkString(std::string &s)
+	: str(s)
+	{ }
+
+	~BufferedSinkString()
+	{
+		this->flushBuffer();
+	}
+
+	using BufferedSink<BufferedSinkString<N>,N>::flush;
+
+	void flush(const uint8_t *b, size_t n)
+	{
+		str.append((const char *)b,n);
+	}
+};
+#endif // WITH_SINK_STRING
+
+
+#ifdef WITH_SINK_FD
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+// BufferedSinkFd: writes to a file descriptor on flush
+// - large byte arrays are written together with the staged data
+//   using writev
+// - getError() returns the errno of the first failed write or 0
+template <size_t N = 4096>
+class BufferedSinkFd : public BufferedSink<BufferedSinkFd<N>,N>
+{
+	int fd, error;
+
+	public:
+	BufferedSinkFd(int f)
+	: fd(f)
+	, error(0)
+	{ }
+
+	~BufferedSinkFd()
+	{
+		this->flushBuffer();
+	}
+
+	void flush(const uint8_t *b, size_t n)
+	{
+		flush(b,n,0,0);
+	}
+
+	void flush(const uint8_t *b0, size_t n0, const uint8_t *b1, size_t n1)
+	{
+		struct iovec iov[2];
+		iov[0].iov_base = (void *) b0;
+		iov[0].iov_len = n0;
+		iov[1].iov_base = (void *) b1;
+		iov[1].iov_len = n1;
+		struct iovec *v = iov;
+		int nv = n1 ? 2 : 1;
+		while (!error && nv) {
+			ssize_t w = writev(fd,v,nv);
+			if (w < 0) {
+				if (errno != EINTR)
+					error = errno;
+				continue;
+			}
+			// skip what has been written
+			while (nv && ((size_t)w >= v->iov_len)) {
+				w -= v->iov_len;
+				++v;
+				--nv;
+			}
+			if (nv) {
+				v->iov_base = (uint8_t *)v->iov_base + w;
+				v->iov_len -= w;
+			}
+		}
+	}
+
+	int getError() const
+	{
+		return error;
+	}
+};
+#endif // WITH_SINK_FD
+
+
 #endif
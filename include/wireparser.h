@@ -0,0 +1,278 @@
+/*
+ *  Copyright (C) 2026, Thomas Maier-Komor
+ *
+ *  This source file belongs to Wire-Format-Compiler.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _WIREPARSER_H
+#define _WIREPARSER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <string>
+
+// WireParser: resumable parser for serialized data that arrives in chunks
+// - base class of the parser class generated with option Parser
+// - runs of fields that are completely available in a chunk are passed
+//   to fromMemory of the message, i.e. the regular field dispatch is used
+// - embedded messages are not collected, but the parser descends into
+//   them using a small explicit stack
+// - only a field that is split across chunks is collected, before it is
+//   passed to fromMemory
+// - fields must not reference the parsed data (i.e. stringtype C or
+//   view), as the chunks need not stay valid
+
+#ifndef WIREPARSER_DEPTH
+#define WIREPARSER_DEPTH 8
+#endif
+
+struct WireParserType
+{
+	// parse complete fields using fromMemory of the message
+	ssize_t (*parse)(void *msg, const void *b, ssize_t s);
+	// embedded message for field tag or 0 if the field has no message type
+	void *(*submsg)(void *msg, unsigned tag, const WireParserType **t);
+};
+
+
+class WireParser
+{
+	public:
+	WireParser(void *m, const WireParserType *t)
+	: sp(0)
+	, header(false)
+	, total(0)
+	{
+		stack[0].msg = m;
+		stack[0].type = t;
+		stack[0].left = 0;
+	}
+
+	/*
+	 * Parse the next chunk of data.
+	 * @return number of bytes consumed (i.e. s) or a negative value
+	 *         indicating an error
+	 */
+	ssize_t feed(const uint8_t *d, size_t s)
+	{
+		const uint8_t *b = d, *e = d + s;
+		while (d < e) {
+			frame *f = stack + sp;
+			if (sp && (f->left == 0)) {
+				if (!buf.empty())
+					return -1;
+				--sp;
+				continue;
+			}
+			size_t avail = e - d;
+			if (sp && (avail > f->left))
+				avail = f->left;
+			if (buf.empty()) {
+				// pass all complete fields in one run to fromMemory
+				const uint8_t *a = d, *fe = d + avail;
+				void *sub = 0;
+				const WireParserType *st = 0;
+				unsigned tag = 0;
+				size_t hdr = 0, fs = 0;
+				while (a < fe) {
+					int r = scan(a,fe,&tag,&hdr,&fs);
+					if (r < 0)
+						return -2;
+					if (r == 0)
+						break;
+					if (((tag & 7) == 2) && (0 != (sub = f->type->submsg(f->msg,tag,&st))))
+						break;
+					if (fs > (size_t)(fe - a))
+						break;
+					a += fs;
+				}
+				if (a != d) {
+					if (f->type->parse(f->msg,d,a-d) != (a-d))
+						return -3;
+					consume(f,a-d);
+					d = a;
+				}
+				if (sub) {
+					consume(f,hdr);
+					d += hdr;
+					if (!push(sub,st,fs-hdr))
+						return -4;
+					continue;
+				}
+				if (d == fe)
+					continue;
+				avail = fe - d;
+			}
+			if (!header) {
+				// field header is split: collect byte by byte
+				buf.push_back(*d++);
+				consume(f,1);
+				unsigned tag;
+				size_t hdr;
+				int r = scan((const uint8_t *)buf.data(),(const uint8_t *)buf.data()+buf.size(),&tag,&hdr,&total);
+				if (r < 0)
+					return -5;
+				if (r == 0)
+					continue;
+				header = true;
+				const WireParserType *st;
+				if ((tag & 7) == 2) {
+					if (void *sub = f->type->submsg(f->msg,tag,&st)) {
+						buf.clear();
+						header = false;
+						if (!push(sub,st,total-hdr))
+							return -6;
+						continue;
+					}
+				}
+			} else {
+				size_t n = total - buf.size();
+				if (n > avail)
+					n = avail;
+				buf.append((const char *)d,n);
+				consume(f,n);
+				d += n;
+			}
+			if (buf.size() == total) {
+				if (f->type->parse(f->msg,buf.data(),total) != (ssize_t)total)
+					return -7;
+				buf.clear();
+				header = false;
+			}
+		}
+		while (sp && (stack[sp].left == 0) && buf.empty())
+			--sp;
+		return d - b;
+	}
+
+	//! @return true if no field or embedded message is incomplete
+	bool complete() const
+	{ return (sp == 0) && buf.empty(); }
+
+	//! restart parsing for message m, discarding incomplete data
+	void reset(void *m)
+	{
+		sp = 0;
+		stack[0].msg = m;
+		buf.clear();
+		header = false;
+	}
+
+	private:
+	struct frame {
+		void *msg;
+		const WireParserType *type;
+		size_t left;	// bytes left of an embedded message
+	};
+
+	bool push(void *m, const WireParserType *t, size_t l)
+	{
+		if (sp && (l > stack[sp].left))
+			return false;
+		if (sp + 1 >= WIREPARSER_DEPTH)
+			return false;
+		if (sp)
+			stack[sp].left -= l;
+		++sp;
+		stack[sp].msg = m;
+		stack[sp].type = t;
+		stack[sp].left = l;
+		return true;
+	}
+
+	void consume(frame *f, size_t n)
+	{
+		if (sp)
+			f->left -= n;
+	}
+
+	// scan the header of the field at a
+	// @return 1 if complete, 0 if more data is needed, <0 on error
+	static int scan(const uint8_t *a, const uint8_t *e, unsigned *tag, size_t *hdr, size_t *fs)
+	{
+		uint64_t v;
+		int n = scan_varint(a,e,&v);
+		if (n <= 0)
+			return n;
+		*tag = v;
+		const uint8_t *h = a + n;
+		switch (v & 7) {
+		case 0:	// varint
+			n = scan_varint(h,e,&v);
+			if (n <= 0)
+				return n;
+			h += n;
+			*hdr = h - a;
+			*fs = *hdr;
+			return 1;
+		case 1:	// 64bit
+			*hdr = h - a;
+			*fs = *hdr + 8;
+			return 1;
+		case 2:	// length prefix
+			n = scan_varint(h,e,&v);
+			if (n <= 0)
+				return n;
+			h += n;
+			*hdr = h - a;
+			*fs = *hdr + v;
+			return 1;
+		case 3:	// 8bit
+			*hdr = h - a;
+			*fs = *hdr + 1;
+			return 1;
+		case 4:	// 16bit
+			*hdr = h - a;
+			*fs = *hdr + 2;
+			return 1;
+		case 5:	// 32bit
+			*hdr = h - a;
+			*fs = *hdr + 4;
+			return 1;
+		default:
+			return -1;
+		}
+	}
+
+	static int scan_varint(const uint8_t *a, const uint8_t *e, uint64_t *v)
+	{
+		uint64_t r = 0;
+		int n = 0;
+		while (a < e) {
+			uint8_t u8 = *a++;
+			if (n < 10)
+				r |= (uint64_t)(u8 & 0x7f) << (n*7);
+			++n;
+			if ((u8 & 0x80) == 0) {
+				*v = r;
+				return n;
+			}
+			if (n == 10)
+				return -1;
+		}
+		return 0;
+	}
+
+	frame stack[WIREPARSER_DEPTH];
+	unsigned sp;
+	bool header;		// header of field in buf is complete
+	size_t total;		// size of field in buf
+	std::string buf;	// field that is split across chunks
+};
+
+
+#endif
@@ -39,6 +39,72 @@ void ascii_indent($streamtype &out, ssize_t n, const char *fname = 0)
 }
 
 
+/* wfc-template:
+ * function: ascii_string
+ * Optimize: speed
+ * description: writes runs of plain characters with a single write
+ */
+void ascii_string_run($streamtype &out, size_t indent, const char *str, size_t len, const char *fname = 0)
+{
+	// escape character of control characters, '.' for octal
+	static const char esc[] = "0......abt.vfr.............e....";
+	if (fname) {
+		out.put('\n');
+		size_t n = indent;
+		while (n > 0) {
+			out.put('\t');
+			--n;
+		}
+		out << fname;
+	}
+	unsigned cil = 0;
+	out << '"';
+	const char *e = str + len;
+	while (str != e) {
+		if (cil == 64) {
+			out << "\"\n";
+			$ascii_indent(out,indent);
+			out << '"';
+			cil = 0;
+		}
+		// plain characters up to the end of the line
+		const char *b = str;
+		const char *m = ((size_t)(e-str) > 64-cil) ? str+64-cil : e;
+		while ((str != m) && ((uint8_t)*str >= 0x20) && ((uint8_t)*str <= 0x7e) && (*str != '"') && (*str != '\\'))
+			++str;
+		if (str != b) {
+			out.write(b,str-b);
+			cil += str-b;
+			continue;
+		}
+		uint8_t c = *str++;
+		++cil;
+		if (c == '\n') {
+			out << "\\n\"\n";
+			$ascii_indent(out,indent);
+			out << '"';
+			continue;
+		}
+		char buf[5];
+		buf[0] = '\\';
+		if ((c < 0x20) && (esc[c] != '.')) {
+			buf[1] = esc[c];
+			out.write(buf,2);
+		} else if ((c == '"') || (c == '\\')) {
+			buf[1] = c;
+			out.write(buf,2);
+		} else {
+			buf[1] = '0';
+			buf[2] = '0' + ((c >> 6) & 0x3);
+			buf[3] = '0' + ((c >> 3) & 0x7);
+			buf[4] = '0' + (c & 0x7);
+			out.write(buf,5);
+		}
+	}
+	out << "\";";
+}
+
+
 /* wfc-template:
  * function: ascii_string
  * sysinclude: string.h
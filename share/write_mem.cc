@@ -242,6 +242,90 @@ void write_u16_lef(uint8_t *wire, uint16_t v)
 }
 
 
+/* wfc-template:
+ * function: rwrite_varint
+ * description: write varint backwards ending at a, returns start or 0 if below b
+ */
+uint8_t *rwrite_varint_0(uint8_t *b, uint8_t *a, varint_t v)
+{
+	if (v < 0x80) {
+		if (a == b)
+			return 0;
+		*--a = v;
+		return a;
+	}
+	unsigned n = 2;
+	for (varint_t x = v >> 14; x; x >>= 7)
+		++n;
+	if ((size_t)(a-b) < n)
+		return 0;
+	a -= n;
+	uint8_t *w = a;
+	do {
+		*w++ = (v & 0x7f) | 0x80;
+		v >>= 7;
+	} while (v >= 0x80);
+	*w = v;
+	return a;
+}
+
+
+/* wfc-template:
+ * function: rwrite_xvarint
+ * description: write sign extended varint backwards ending at a, returns start or 0 if below b
+ */
+uint8_t *rwrite_xvarint_0(uint8_t *b, uint8_t *a, varint_t v)
+{
+	uint64_t u64 = (uint64_t)(int64_t)(varsint_t)v;
+	unsigned n = 1;
+	for (uint64_t x = u64 >> 7; x; x >>= 7)
+		++n;
+	if ((size_t)(a-b) < n)
+		return 0;
+	a -= n;
+	uint8_t *w = a;
+	while (u64 >= 0x80) {
+		*w++ = (u64 & 0x7f) | 0x80;
+		u64 >>= 7;
+	}
+	*w = u64;
+	return a;
+}
+
+
+/* wfc-template:
+ * function: uwrite_varint
+ * description: write varint without bounds check, returns number of bytes written
+ */
+unsigned uwrite_varint_0(uint8_t *w, varint_t v)
+{
+	uint8_t *s = w;
+	while (v >= 0x80) {
+		*w++ = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	*w++ = v;
+	return w-s;
+}
+
+
+/* wfc-template:
+ * function: uwrite_xvarint
+ * description: write sign extended varint without bounds check, returns number of bytes written
+ */
+unsigned uwrite_xvarint_0(uint8_t *w, varint_t v)
+{
+	uint64_t u64 = (uint64_t)(int64_t)(varsint_t)v;
+	uint8_t *s = w;
+	while (u64 >= 0x80) {
+		*w++ = (u64 & 0x7f) | 0x80;
+		u64 >>= 7;
+	}
+	*w++ = u64;
+	return w-s;
+}
+
+
 /* no-wfc-template:
  * function: write_float
  */
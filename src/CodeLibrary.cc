@@ -307,35 +307,41 @@ CodeTemplate *CodeLibrary::getTemplate(codeid_t f, const Options *o) const
 }
 
 
+void CodeLibrary::collect_dependencies(vector<codeid_t> &deps, set<codeid_t> &visited, CodeTemplate *t, const Options *options) const
+{
+	// depth first, so that every function follows the functions it requires
+	for (const string &n : t->getDependencies()) {
+		dbug("adding dependency: %s",n.c_str());
+		codeid_t id = CodeTemplate::getFunctionId(n);
+		if (id == ct_invalid) {
+			warn("unable to find depency %s",n.c_str());
+		} else if (visited.insert(id).second) {
+			if (CodeTemplate *d = getTemplate(id,options))
+				collect_dependencies(deps,visited,d,options);
+			deps.push_back(id);
+		}
+	}
+}
+
+
 void CodeLibrary::add_dependencies(vector<unsigned> &funcs, const Options *options, libmode_t lm) const
 {
-	set<string> deps;
+	vector<codeid_t> deps;
+	set<codeid_t> visited;
 	for (auto id : funcs) {
 		if (id & 0x10000)
 			continue;
 		CodeTemplate *t = getTemplate((codeid_t)id,options);
 		if (t == 0)
 			continue;
-		const vector<string> &d = t->getDependencies();
-		deps.insert(d.begin(),d.end());
+		collect_dependencies(deps,visited,t,options);
 	}
-	if (deps.empty())
-		return;
-	set<codeid_t> all;
-	for (auto x: funcs)
-		all.insert((codeid_t)x);
-	for (const string &n: deps) {
-		dbug("adding dependency: %s",n.c_str());
-		codeid_t id = CodeTemplate::getFunctionId(n);
-		if (id == ct_invalid) {
-			warn("unable to find depency %s",n.c_str());
-		} else if (all.insert(id).second) {
-			funcs.insert(funcs.begin(),id);
-		} else {
-			// dependency already exists => move it to front
-			funcs.erase(find(funcs.begin(),funcs.end(),(unsigned)id));
-			funcs.insert(funcs.begin(),id);
-		}
+	// put dependencies in front, existing ones are moved to front
+	for (auto i = deps.rbegin(), e = deps.rend(); i != e; ++i) {
+		auto x = find(funcs.begin(),funcs.end(),(unsigned)*i);
+		if (x != funcs.end())
+			funcs.erase(x);
+		funcs.insert(funcs.begin(),*i);
 	}
 }
 
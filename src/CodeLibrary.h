@@ -49,6 +49,7 @@ class CodeLibrary
 	void addFile(const char *fn, struct stat * = 0);
 	CodeTemplate *getTemplate(codeid_t, const Options *o) const;
 	void add_dependencies(std::vector<unsigned> &funcs, const Options *options, libmode_t lm) const;
+	void collect_dependencies(std::vector<codeid_t> &deps, std::set<codeid_t> &visited, CodeTemplate *t, const Options *options) const;
 
 	std::multimap<codeid_t, CodeTemplate *> m_templates;
 	std::map<std::string, CodeTemplate *> m_functions;
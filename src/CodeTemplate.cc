@@ -67,6 +67,8 @@ const char *Functions[] = {
 	"read_u32",
 	"read_u64",
 	"read_varint",
+	"rwrite_varint",
+	"rwrite_xvarint",
 	"send_bytes",
 	"send_msg",
 	"send_u16",
@@ -76,8 +78,11 @@ const char *Functions[] = {
 	"send_xvarint",
 	"sint_varint",
 	"skip_content",
+	"skip_fields",
 	"to_dblstr",
 	"to_decstr",
+	"uwrite_varint",
+	"uwrite_xvarint",
 	"varint_sint",
 	"wiresize",
 	"wiresize_s",
@@ -89,6 +94,24 @@ const char *Functions[] = {
 	"write_xvarint",
 	"CStrLess",
 	"encode_bytes",
+	"json_skip_ws",
+	"json_parse_string",
+	"json_unescape",
+	"json_assign_string",
+	"json_parse_int",
+	"json_parse_uint",
+	"json_parse_dbl",
+	"json_parse_bool",
+	"json_skip_value",
+	"grisu_digits",
+	"json_buf_decstr",
+	"json_buf_dblstr",
+	"json_buf_key",
+	"json_buf_escape",
+	"json_buf_string",
+	"json_buf_cstr",
+	"json_strsize",
+	"json_cstrsize",
 	0
 };
 
@@ -298,7 +321,8 @@ codeid_t CodeTemplate::getFunctionId() const
 bool CodeTemplate::fitsOptions(const Options *o) const
 {
 	const string &v = o->getOption(function.c_str());
-	if (v != "") {
+	// option set to the function name itself: pick variant by requirements
+	if ((v != "") && (v != function)) {
 		diag("fit functionname %s with %s",v.c_str(),variant.c_str());
 		return (v == variant);
 	}
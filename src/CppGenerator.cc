@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <set>
 #include <string>
@@ -49,11 +50,18 @@ CppGenerator::CppGenerator(PBFile *p, Options *o)
 , usesArrays(false)
 , usesVectors(false)
 , usesStringTypes(false)
+, usesViews(false)
 , PaddedMsgSize(false)
+, CachedSize(false)
 , SinkToTemplate(false)
 , WithComments(true)
 , WithJson(false)
+, WithFieldMask(false)
+, WithParser(false)
+, WithDelta(false)
+, WithMerge(false)
 , EarlyDecode(false)
+, TagPrediction(false)
 , inlineClear(true)
 , inlineHas(true)
 , inlineGet(true)
@@ -90,6 +98,7 @@ CppGenerator::CppGenerator(PBFile *p, Options *o)
 , hasRBytes(false)
 , hasRString(false)
 , hasUnused(false)
+, hasLazy(false)
 , needJsonString(false)
 , needCalcSize(false)
 , needSendVarSInt(false)
@@ -178,6 +187,47 @@ void CppGenerator::setTarget(const char *t)
 	if (optmode == optsize)
 		EarlyDecode = true;
 	PaddedMsgSize = target->getFlag("padded_message_size");
+	CachedSize = target->getFlag("CachedSize");
+	TagPrediction = target->getFlag("TagPrediction");
+	WithParser = target->isId("Parser");
+	WithFieldMask = target->getFlag("FieldMask");
+	if (WithParser || WithFieldMask) {
+		if (!target->isId("fromMemory")) {
+			if (WithParser)
+				warn("option Parser requires fromMemory, omitting generation of parser");
+			if (WithFieldMask)
+				warn("option FieldMask requires fromMemory, omitting generation of masked decoding");
+			WithParser = false;
+			WithFieldMask = false;
+		} else if (terminatorByte() >= 0) {
+			if (WithParser)
+				warn("option Parser is incompatible with option Terminator, omitting generation of parser");
+			if (WithFieldMask)
+				warn("option FieldMask is incompatible with option Terminator, omitting generation of masked decoding");
+			WithParser = false;
+			WithFieldMask = false;
+		}
+	}
+	WithDelta = target->isId("toMemoryDelta");
+	if (WithDelta && !target->isId("toMemory")) {
+		warn("option toMemoryDelta requires toMemory, omitting generation of delta serialization");
+		WithDelta = false;
+	} else if (WithDelta && !target->isId("markClean")) {
+		warn("option toMemoryDelta requires markClean, omitting generation of delta serialization");
+		WithDelta = false;
+	}
+	WithMerge = target->isId("mergeFromMemory");
+	if (WithMerge) {
+		if (!target->isId("fromMemory")) {
+			warn("option mergeFromMemory requires fromMemory, omitting generation of merge decoding");
+			WithMerge = false;
+		} else if (terminatorByte() >= 0) {
+			warn("option mergeFromMemory is incompatible with option Terminator, omitting generation of merge decoding");
+			WithMerge = false;
+		}
+	}
+	if (target->isId("toJSONBuffer") && (target->getOption("json_indent") != "json_indent"))
+		error("option toJSONBuffer does not support a custom json_indent");
 	const char *inlopt = target->getOption("inline").c_str();
 	if (strstr(inlopt,"!has"))
 		inlineHas = false;
@@ -398,6 +448,67 @@ void CppGenerator::writeClearValid(Generator &G, int vbit)
 }
 
 
+static bool hasMember(Field *f)
+{
+	// the value of the field is stored in a member of its message
+	return (f != 0) && f->isUsed() && !f->isObsolete() && !f->isVirtual();
+}
+
+
+static bool hasDirtyBit(Field *f)
+{
+	return hasMember(f);
+}
+
+
+static unsigned numDirtyBits(Message *m)
+{
+	unsigned n = 0;
+	for (auto i : m->getFields()) {
+		if (hasDirtyBit(i.second))
+			++n;
+	}
+	return n;
+}
+
+
+static unsigned getDirtyBit(Field *f)
+{
+	// dirty bits are assigned in the order of the fields
+	unsigned n = 0;
+	for (auto i : f->getParent()->getFields()) {
+		if (i.second == f)
+			return n;
+		if (hasDirtyBit(i.second))
+			++n;
+	}
+	abort();
+}
+
+
+string CppGenerator::setDirty(Field *f)
+{
+	if (!WithDelta)
+		return "";
+	unsigned d = getDirtyBit(f);
+	char buf[64];
+	sprintf(buf,"p_dirtybits[%u] |= 0x%x;\n",d/8,1<<(d&7));
+	return buf;
+}
+
+
+string CppGenerator::setDirtyIf(Field *f, const char *cond)
+{
+	if (!WithDelta)
+		return "";
+	string r = "if (";
+	r += cond;
+	r += ")\n\t";
+	r += setDirty(f);
+	return r;
+}
+
+
 void CppGenerator::initNames(Message *m, const string &prefix)
 {
 	//diag("initNames(%s,%s)",m->getName().c_str(),prefix.c_str());
@@ -467,6 +578,8 @@ void CppGenerator::initVBits(Message *m)
 		case ft_string:
 		case ft_bytes:
 			usesStringTypes = true;
+			if (0 == strcmp(f->getTypeName(),"BufView"))
+				usesViews = true;
 			break;
 		default:;
 		}
@@ -510,6 +623,7 @@ void CppGenerator::init()
 	usesVectors = false;
 	usesBytes = false;
 	usesStringTypes = false;
+	usesViews = false;
 	for (unsigned i = 0, n = file->numMessages(); i != n; ++i) {
 		Message *m = file->getMessage(i);
 		m->setOptions(target);
@@ -535,6 +649,8 @@ void CppGenerator::scanRequirements(Message *m)
 		}
 		if (f->isObsolete())
 			continue;
+		if (f->isLazy())
+			hasLazy = true;
 		int id = f->getId();
 		if ((id == 0) && !target->getFlag("id0"))
 			error("Use of id 0 requires special considerations. Enable support for it with option id0.");
@@ -719,6 +835,12 @@ static void allHelpers(vector<unsigned> &funcs, bool VarIntBits64)
 	funcs.push_back(ct_write_u16);
 	funcs.push_back(ct_write_u32);
 	funcs.push_back(ct_write_u64);
+	funcs.push_back(ct_rwrite_varint);
+	if (!VarIntBits64)
+		funcs.push_back(ct_rwrite_xvarint);
+	funcs.push_back(ct_uwrite_varint);
+	if (!VarIntBits64)
+		funcs.push_back(ct_uwrite_xvarint);
 	funcs.push_back(ct_decode_union);
 	funcs.push_back(ct_decode_early);
 	funcs.push_back(ct_read_varint);
@@ -728,6 +850,17 @@ static void allHelpers(vector<unsigned> &funcs, bool VarIntBits64)
 	funcs.push_back(ct_read_double);
 	funcs.push_back(ct_read_float);
 	funcs.push_back(ct_skip_content);
+	funcs.push_back(ct_skip_fields);
+
+	funcs.push_back(ct_json_skip_ws);
+	funcs.push_back(ct_json_parse_string);
+	funcs.push_back(ct_json_unescape);
+	funcs.push_back(ct_json_assign_string);
+	funcs.push_back(ct_json_parse_int);
+	funcs.push_back(ct_json_parse_uint);
+	funcs.push_back(ct_json_parse_dbl);
+	funcs.push_back(ct_json_parse_bool);
+	funcs.push_back(ct_json_skip_value);
 
 	funcs.push_back(ct_ascii_indent);
 	funcs.push_back(ct_ascii_bool);
@@ -740,6 +873,13 @@ static void allHelpers(vector<unsigned> &funcs, bool VarIntBits64)
 	funcs.push_back(ct_json_cstr);
 	funcs.push_back(ct_to_decstr);
 	funcs.push_back(ct_to_dblstr);
+	funcs.push_back(ct_json_buf_key);
+	funcs.push_back(ct_json_buf_string);
+	funcs.push_back(ct_json_buf_cstr);
+	funcs.push_back(ct_json_strsize);
+	funcs.push_back(ct_json_cstrsize);
+	funcs.push_back(ct_json_buf_decstr);
+	funcs.push_back(ct_json_buf_dblstr);
 
 	funcs.push_back(ct_parse_ascii_bool);
 	funcs.push_back(ct_parse_ascii_bytes);
@@ -946,6 +1086,8 @@ void CppGenerator::writeMemberDef(Generator &G, Field *f)
 	if (s == mem_static) {
 		G << "static ";
 	}
+	if (f->isLazy())
+		G << "mutable ";
 	bool repeated = false;
 	switch (f->getQuantifier()) {
 	case q_optional:
@@ -971,6 +1113,15 @@ void CppGenerator::writeMemberDef(Generator &G, Field *f)
 		}
 	}
 	G << ";\n";
+	if (f->isLazy()) {
+		if (WithComments)
+			G << "//! serialized data of $(fname) that has not been decoded yet\n";
+		G <<	"mutable const uint8_t *lazy_$(fname) = 0;\n"
+			"mutable size_t lazysize_$(fname) = 0;\n";
+		if (WithComments)
+			G << "//! $(fname) may hold data, so new data must be merged\n";
+		G <<	"mutable bool lazyused_$(fname) = false;\n";
+	}
 	G.setField(0);
 }
 
@@ -1482,6 +1633,18 @@ void CppGenerator::writeClass(Generator &G, Message *m)
 			" * @return bytes needed for a serialized object representation\n"
 			" */\n";
 	G <<	"size_t $calcSize() const;\n\n";
+	if (CachedSize) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Size of the serialized object as determined by the last call of\n"
+				" * $calcSize. Serializing a message uses the cached size of its\n"
+				" * embedded messages. Therefore, $calcSize must be called after\n"
+				" * modifying the object and before serializing it.\n"
+				" * @return cached number of bytes of the serialized object\n"
+				" */\n";
+		G <<	"size_t cachedSize() const\n"
+			"{ return p_cachedsize; }\n\n";
+	}
 	if (G.hasValue("fromMemory")) {
 		if (WithComments)
 			G <<	"/*!\n"
@@ -1493,6 +1656,77 @@ void CppGenerator::writeClass(Generator &G, Message *m)
 				" *         or a negative value indicating the error encountered\n"
 				" */\n";
 		G <<	"ssize_t $(fromMemory)(const void *b, ssize_t s);\n\n";
+		if (WithFieldMask) {
+			if (WithComments)
+				G <<	"/*!\n"
+					" * Function for parsing only the fields selected by a field mask.\n"
+					" * All other fields are skipped without being decoded.\n"
+					" * @param b buffer of serialized data\n"
+					" * @param s number of bytes available in the buffer\n"
+					" * @param fm ids of the fields to decode\n"
+					" * @return number of bytes successfully parsed (can be < s)\n"
+					" *         or a negative value indicating the error encountered\n"
+					" */\n";
+			G <<	"ssize_t $(fromMemory)(const void *b, ssize_t s, const FieldMask &fm);\n\n";
+		}
+		if (WithMerge) {
+			if (WithComments)
+				G <<	"/*!\n"
+					" * Function for merging serialized data into this object.\n"
+					" * Fields present in the data overwrite the current values,\n"
+					" * embedded messages are merged recursively, and repeated\n"
+					" * fields are replaced or appended to according to their\n"
+					" * option merge. Fields not present are left untouched.\n"
+					" * @param b buffer of serialized data\n"
+					" * @param s number of bytes available in the buffer\n"
+					" * @return number of bytes successfully parsed (can be < s)\n"
+					" *         or a negative value indicating the error encountered\n"
+					" */\n";
+			G <<	"ssize_t $(mergeFromMemory)(const void *b, ssize_t s);\n\n";
+			if (WithComments)
+				G <<	"/*!\n"
+					" * Clears the repeated fields that are replaced by\n"
+					" * $(mergeFromMemory), including those of embedded messages.\n"
+					" * @param b buffer of serialized data\n"
+					" * @param s number of bytes available in the buffer\n"
+					" * @param clear false to only check the data\n"
+					" * @return 0 or a negative value indicating the error encountered\n"
+					" */\n";
+			G <<	"ssize_t $(prepareMerge)(const void *b, ssize_t s, bool clear);\n\n";
+		}
+		if (WithParser) {
+			if (WithComments)
+				G <<	"/*!\n"
+					" * Resumable parser for serialized data arriving in chunks.\n"
+					" * Use feed() to pass the chunks of data as they arrive.\n"
+					" * Complete fields are decoded with $(fromMemory).\n"
+					" */\n";
+			G <<	"class $(parser) : public WireParser\n"
+				"{\n"
+				"public:\n"
+				"explicit $(parser)($(msg_name) &m)\n"
+				": WireParser(&m,&Type)\n"
+				"{ }\n"
+				"\n"
+				"static const WireParserType Type;\n"
+				"static ssize_t parse(void *, const void *, ssize_t);\n"
+				"static void *submsg(void *, unsigned, const WireParserType **);\n"
+				"};\n\n";
+		}
+	}
+	if (G.hasValue("validate")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for checking that serialized data is a well-formed\n"
+				" * instance of this message without decoding it.\n"
+				" * All tags must be known, lengths must be in bounds, embedded\n"
+				" * messages must be valid, and required fields must be present.\n"
+				" * @param b buffer of serialized data\n"
+				" * @param s number of bytes available in the buffer\n"
+				" * @return number of bytes checked (can be < s with a terminator)\n"
+				" *         or -1 if the data is invalid\n"
+				" */\n";
+		G <<	"static ssize_t $(validate)(const void *b, ssize_t s);\n\n";
 	}
 	if (G.hasValue("toMemory")) {
 		if (WithComments)
@@ -1504,9 +1738,64 @@ void CppGenerator::writeClass(Generator &G, Message *m)
 				" */\n";
 		G <<	"ssize_t $(toMemory)(uint8_t *, ssize_t) const;\n\n";
 	}
+	if (G.hasValue("toMemoryReverse")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the object to the end of a buffer.\n"
+				" * Fields are written back to front, so the size of embedded\n"
+				" * messages is known when their length is written.\n"
+				" * @param b buffer to serialize the object to\n"
+				" * @param s number of bytes available in the buffer\n"
+				" * @return offset of the serialized data, which ends at b+s,\n"
+				" *         or a negative value indicating the error encountered\n"
+				" */\n";
+		G <<	"ssize_t $(toMemoryReverse)(uint8_t *, ssize_t) const;\n\n";
+	}
+	if (WithDelta) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the fields that were modified\n"
+				" * since the last call of $(markClean). Virtual fields are\n"
+				" * always serialized. Apply the data with $(mergeFromMemory)\n"
+				" * or $(fromMemory) to the receiving object.\n"
+				" * @param b buffer to serialize the object to\n"
+				" * @param s number of bytes available in the buffer\n"
+				" * @return number of bytes successfully serialized\n"
+				" */\n";
+		G <<	"ssize_t $(toMemoryDelta)(uint8_t *, ssize_t) const;\n\n";
+		if (WithComments)
+			G <<	"//! Reset the modification state of all fields.\n";
+		G <<	"void $(markClean)();\n\n";
+	}
+	if (G.hasValue("toMemoryUnchecked")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the object to memory without\n"
+				" * checking the bounds of the buffer.\n"
+				" * @param b buffer to serialize the object to, which must\n"
+				" *        provide at least $calcSize() bytes\n"
+				" * @return number of bytes written\n"
+				" */\n";
+		G <<	"ssize_t $(toMemoryUnchecked)(uint8_t *) const;\n\n";
+	}
+	if (G.hasValue("toIovec")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the object to an iovec array.\n"
+				" * Large payloads are referenced in place without copying.\n"
+				" * @param v builder for the iovec array\n"
+				" * @return number of bytes added\n"
+				" */\n";
+		G <<	"ssize_t $(toIovec)(IovecBuilder &) const;\n\n";
+	}
 	if (G.hasValue("toWire")) {
 		G.setMode(gen_wire);
-		if (WithComments)
+		if (WithComments && G.hasValue("wirewrite"))
+			G <<	"/*!\n"
+				"* Serialize the object using function '$wirewrite' for transmitting\n"
+				"* blocks of data on the wire.\n"
+				"*/\n";
+		else if (WithComments)
 			G <<	"/*!\n"
 				"* Serialize the object using a function for transmitting individual bytes.\n"
 				"* @param put function to put individual bytes for transmission on the wire\n"
@@ -1534,6 +1823,57 @@ void CppGenerator::writeClass(Generator &G, Message *m)
 				" */\n";
 		G <<	"void $(toJSON)($(streamtype) &json, unsigned indLvl = 0) const;\n\n";
 	}
+	if (G.hasValue("fromJSON")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for parsing a JSON object into this object.\n"
+				" * Keys that do not refer to a field are skipped, arrays\n"
+				" * replace the content of repeated fields.\n"
+				" * @param json JSON input\n"
+				" * @param n number of characters available\n"
+				" * @return number of characters parsed\n"
+				" *         or a negative value indicating the error encountered\n"
+				" */\n";
+		G <<	"ssize_t $(fromJSON)(const char *json, size_t n);\n\n";
+	}
+	if (G.hasValue("toJSONBuffer")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for writing the JSON representation of this object\n"
+				" * to a buffer. The output is not terminated by \\0.\n"
+				" * @param b buffer for the JSON output\n"
+				" * @param n number of bytes available in the buffer\n"
+				" * @return number of bytes written\n"
+				" *         or a negative value indicating the error encountered\n"
+				" */\n";
+		G <<	"ssize_t $(toJSONBuffer)(char *b, size_t n) const;\n\n";
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for writing the JSON representation of this object\n"
+				" * to a buffer without checking its bounds.\n"
+				" * @param b buffer for the JSON output, which must provide\n"
+				" *        at least $(calcJSONSize)(indLvl) bytes\n"
+				" * @param indLvl current indention level\n"
+				" * @return end of the JSON output\n"
+				" */\n";
+		G <<	"char *$(toJSONBuffer)Unchecked(char *b, unsigned indLvl = 0) const;\n\n";
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for calculating an upper bound of the size of the\n"
+				" * JSON representation of this object. Strings are accounted\n"
+				" * exactly, numbers with their maximum length.\n"
+				" * @param indLvl current indention level\n"
+				" */\n";
+		G <<	"size_t $(calcJSONSize)(unsigned indLvl = 0) const;\n\n";
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for determining the maximum size of the JSON\n"
+				" * representation of any object of this type.\n"
+				" * @param indLvl current indention level\n"
+				" * @return maximum number of bytes or SIZE_MAX if no limit can be determined\n"
+				" */\n";
+		G <<	"static size_t $(maxJSONSize)(unsigned indLvl = 0);\n\n";
+	}
 	if (PrintOut) {
 		if (WithComments)
 			G <<	"/*!\n"
@@ -1578,10 +1918,26 @@ void CppGenerator::writeClass(Generator &G, Message *m)
 		"protected:\n";
 	for (auto i : m->getFields())
 		writeProtDecl(G,i.second,WithComments);
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed() || f->isObsolete() || !f->isLazy())
+			continue;
+		G.setField(f);
+		if (WithComments)
+			G << "//! Function for decoding $(fname) on first access.\n";
+		G << "void lazy_decode_$(fname)() const;\n";
+		G.setField(0);
+	}
 	writeMembers(G,m,0);
 	unsigned numValid = m->getNumValid();
-	if (numValid > 0) {
+	unsigned numDirty = WithDelta ? numDirtyBits(m) : 0;
+	if ((numValid > 0) || (numDirty > 0) || CachedSize)
 		G << "\nprivate:\n";
+	if (CachedSize)
+		G << "mutable size_t p_cachedsize = 0;\n";
+	if (numDirty > 0)
+		G << "uint8_t p_dirtybits[" << (numDirty+7)/8 << "] = {0};\n";
+	if (numValid > 0) {
 		if (numValid > VarIntBits) {
 			G	<< "uint8_t p_validbits[$numvalidbytes] = {0};\n";
 		} else if (numValid <= 8) {
@@ -1728,6 +2084,48 @@ void CppGenerator::writeBaseClass(Generator &G)
 				" */\n";
 		G << 	"virtual ssize_t $toMemory(uint8_t *, ssize_t) const = 0;\n";
 	}
+	if (G.hasValue("toMemoryReverse")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the object to the end of a buffer.\n"
+				" * @param b buffer to serialize the object to\n"
+				" * @param s number of bytes available in the buffer\n"
+				" * @return offset of the serialized data, which ends at b+s\n"
+				" */\n";
+		G << 	"virtual ssize_t $(toMemoryReverse)(uint8_t *, ssize_t) const = 0;\n";
+	}
+	if (WithDelta) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the fields that were modified\n"
+				" * since the last call of $(markClean). Virtual fields are\n"
+				" * always serialized.\n"
+				" * @param b buffer to serialize the object to\n"
+				" * @param s number of bytes available in the buffer\n"
+				" * @return number of bytes successfully serialized\n"
+				" */\n";
+		G << 	"virtual ssize_t $(toMemoryDelta)(uint8_t *, ssize_t) const = 0;\n"
+			"virtual void $(markClean)() = 0;\n";
+	}
+	if (G.hasValue("toMemoryUnchecked")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the object to memory without\n"
+				" * checking the bounds of the buffer.\n"
+				" * @param b buffer to serialize the object to\n"
+				" * @return number of bytes written\n"
+				" */\n";
+		G << 	"virtual ssize_t $(toMemoryUnchecked)(uint8_t *) const = 0;\n";
+	}
+	if (G.hasValue("toIovec")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * Function for serializing the object to an iovec array.\n"
+				" * @param v builder for the iovec array\n"
+				" * @return number of bytes added\n"
+				" */\n";
+		G << 	"virtual ssize_t $(toIovec)(IovecBuilder &) const = 0;\n";
+	}
 
 	if (G.hasValue("toJSON")) {
 		if (WithComments)
@@ -1738,6 +2136,25 @@ void CppGenerator::writeBaseClass(Generator &G)
 				" */\n";
 		G <<	"virtual void $(toJSON)($(streamtype) &json, unsigned indLvl = 0) const = 0;\n";
 	}
+	if (G.hasValue("fromJSON")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * parse message from JSON\n"
+				" * @param json: JSON input\n"
+				" * @param n: number of characters available\n"
+				" */\n";
+		G <<	"virtual ssize_t $(fromJSON)(const char *json, size_t n) = 0;\n";
+	}
+	if (G.hasValue("toJSONBuffer")) {
+		if (WithComments)
+			G <<	"/*!\n"
+				" * write message as JSON to a buffer\n"
+				" * @param b: buffer for JSON output\n"
+				" * @param n: number of bytes available\n"
+				" */\n";
+		G <<	"virtual ssize_t $(toJSONBuffer)(char *b, size_t n) const = 0;\n"
+			"virtual size_t $(calcJSONSize)(unsigned indLvl = 0) const = 0;\n";
+	}
 	if (G.hasValue("toASCII")) {
 		if (WithComments)
 			G <<	"/*!\n"
@@ -1790,6 +2207,8 @@ void CppGenerator::writeHeader(const string &bn)
 		out << "#include <array.h>\n";
 	else if (WithComments)
 		out << "/* array support not needed */\n";
+	if (usesViews)
+		out << "#include <bufview.h>\n";
 	out <<	"#include <stddef.h>\n"
 		"#include <stdlib.h>\n"
 		"#include <stdint.h>\n"
@@ -1828,6 +2247,12 @@ void CppGenerator::writeHeader(const string &bn)
 		else
 			G << "#include <sink.h>\n";
 	}
+	if (G.hasValue("toIovec"))
+		G << "#include <iovecbuilder.h>\n";
+	if (WithFieldMask)
+		G << "#include <fieldmask.h>\n";
+	if (WithParser)
+		G << "#include <wireparser.h>\n";
 	if (usesBytes)
 		G << "#include <bytes.h>\n";
 	else if (WithComments)
@@ -1843,7 +2268,10 @@ void CppGenerator::writeHeader(const string &bn)
 		G << "typedef $ssize_t ssize_t;\n";
 	G << "typedef uint$(VarIntBits)_t varint_t;\n\n";
 	G << "typedef int$(VarIntBits)_t varsint_t;\n\n";
-	if (!WireputArg) {
+	if (G.hasValue("wirewrite")) {
+		G <<	"#define WIREWRITE_FUNCTION $wirewrite\n"
+			"void $wirewrite(const uint8_t *, size_t);\n\n";
+	} else if (!WireputArg) {
 		G <<	"#define WIREPUT_FUNCTION $wireput\n"
 			"void $wireput(uint8_t);\n\n";
 	}
@@ -1906,8 +2334,10 @@ void CppGenerator::writeGet(Generator &G, Field *f)
 	uint8_t q = f->getQuantifier();
 	if (q != q_repeated) {
 		G <<	"$(inline)$(fullrtype)$(prefix)$(msg_name)::$(field_get)() const\n"
-			"{\n"
-			"return m_$(fname);\n"
+			"{\n";
+		if (f->isLazy())
+			G <<	"lazy_decode_$(fname)();\n";
+		G <<	"return m_$(fname);\n"
 			"}\n\n";
 	} else {
 		G <<	"$(inline)$(fullrtype)$(prefix)$(msg_name)::$(field_get)(unsigned x) const\n"
@@ -1940,21 +2370,28 @@ void CppGenerator::writeMutable(Generator &G, Field *f)
 	if (q == q_optional) {
 		G <<	"$(inline)$(fulltype) $(T)$(prefix)$(msg_name)::$(field_mutable)()\n"
 			"{\n";
+		G << setDirty(f);
 		writeResetUnset(G,f);
+		if (f->isLazy())
+			G <<	"lazy_decode_$(fname)();\n";
 		G <<	"return $(R)m_$(fname);\n"
 			"}\n\n"
 			;
 	} else if (q == q_required) {
 		G <<	"$(inline)$(fulltype) $(T)$(prefix)$(msg_name)::$(field_mutable)()\n"
-			"{\n"
-			"return $(R)m_$(fname);\n"
+			"{\n";
+		G << setDirty(f);
+		if (f->isLazy())
+			G <<	"lazy_decode_$(fname)();\n";
+		G <<	"return $(R)m_$(fname);\n"
 			"}\n\n"
 			;
 	} else if ((q == q_repeated) && (t != ft_bool)) {
 		G.setVariable("index","[x]");
 		G <<	"$(inline)$(fulltype) $(T)$(prefix)$(msg_name)::$(field_mutable)(unsigned x)\n"
 			"{\n"
-			"if (x >= $(field_size))\n";
+		<<	setDirty(f)
+		<<	"if (x >= $(field_size))\n";
 		if (const char *def = f->getDefaultValue())
 			G <<	"m_$(fname).resize(x+1," << def << ");\n";
 		else
@@ -1976,7 +2413,8 @@ void CppGenerator::writeMutable(Generator &G, Field *f)
 		else
 			G << '*';
 		G << "$(prefix)$(msg_name)::$(field_mutable)()\n"
-			"{\n";
+			"{\n"
+		<<	setDirty(f);
 		if (mut_ref)
 			G << "return m_$(fname);\n";
 		else
@@ -1993,6 +2431,8 @@ void CppGenerator::writeSet(Generator &G, Field *f)
 	uint8_t q = f->getQuantifier();
 	int vbit = f->getValidBit();
 	string setvalid = setValid(vbit,f->getParent()->getNumValid());
+	string setdirty = setDirty(f);
+	setvalid += setdirty;
 	if (q_repeated != q) {
 		if ((t == ft_bytes) || (t == ft_string)) {
 			G <<	"$(inline)void $(prefix)$(msg_name)::$(field_set)(const void *data, size_t s)\n"
@@ -2029,31 +2469,37 @@ void CppGenerator::writeSet(Generator &G, Field *f)
 		G <<	"$(inline)void $(prefix)$(msg_name)::$(field_set)($(fullrtype)v)\n"
 			"{\n"
 			"m_$(fname) = v;\n"
-			"}\n\n";
+		<<	setdirty
+		<<	"}\n\n";
 	} else if (q == q_repeated) {
 		if (f->hasMessageType())
 			G <<	"$(inline)$(fulltype) *$(prefix)$(msg_name)::$(field_add)()\n"
 				"{\n"
-				"m_$(fname).resize($(field_size)+1);\n"
+			<<	setdirty
+			<<	"m_$(fname).resize($(field_size)+1);\n"
 				"return &m_$(fname).back();\n"
 				"}\n\n";
 		else if (f->hasSimpleType())
 			G <<	"$(inline)void $(prefix)$(msg_name)::$(field_add)($(typestr) v)\n"
 				"{\n"
 				"m_$(fname).push_back(v);\n"
-				"}\n\n";
+			<<	setdirty
+			<<	"}\n\n";
 		else
 			G <<	"$(inline)void $(prefix)$(msg_name)::$(field_add)($(fullrtype)v)\n"
 				"{\n"
 				"m_$(fname).push_back(v);\n"
-				"}\n\n";
+			<<	setdirty
+			<<	"}\n\n";
 		if (t == ft_string)
 			G <<	"$(inline)void $(prefix)$(msg_name)::$(field_add)(const char *s)\n"
 				"{\n"
 				"m_$(fname).push_back(s);\n"
-				"}\n\n";
+			<<	setdirty
+			<<	"}\n\n";
 		G <<	"$(inline)void $(prefix)$(msg_name)::$(field_set)(unsigned x, $(fullrtype)v)\n"
-			"{\n";
+			"{\n"
+		<<	setdirty;
 		if (Asserts)
 			G <<	"assert(x < $(field_size));\n";
 		G <<	"m_$(fname)[x] = v;\n"
@@ -2077,8 +2523,10 @@ void CppGenerator::writeSetByNameR(Generator &G, Field *f)
 		"	x = m_$fname.size();\n"
 		"	m_$fname.resize(x+1);\n"
 		"	idxe = (char*)(name + $($fnamelen+2));\n"
-		"	if (value == 0)\n"
-		"		return 0;\n"
+		"	if (value == 0) {\n"
+	<<	setDirty(f)
+	<<	"		return 0;\n"
+		"	}\n"
 		"} else {\n"
 	       	"	x = strtoul(name+$($fnamelen+1),&idxe,0);\n"
 		"	if ((idxe[0] != ']') || (idxe == (name+$($fnamelen+1))))\n"
@@ -2087,19 +2535,24 @@ void CppGenerator::writeSetByNameR(Generator &G, Field *f)
 		"		$handle_error;\n"
 		"	if ((idxe[1] == 0) && (value == 0)) {\n"
 		"		m_$fname.erase(m_$fname.begin()+x);\n"
-		"		return 0;\n"
+	<<	setDirty(f)
+	<<	"		return 0;\n"
 		"	}\n"
 		"}\n";
 	if ((t & ft_filter) == ft_msg) {
 		G <<	"if (idxe[1] != '.')\n"
 			"	$handle_error;\n"
-			"return m_$(fname)[x].$(set_by_name)(idxe+2,value);\n"
+			"int r = m_$(fname)[x].$(set_by_name)(idxe+2,value);\n"
+		<<	setDirtyIf(f,"r >= 0")
+		<<	"return r;\n"
 			"}\n"
 			"}\n";
 		return;
 	}
 	if (!f->getParseAsciiFunction().empty()) {
-		G <<	"return $parse_ascii(&m_$fname[x],value);\n"
+		G <<	"int r = $parse_ascii(&m_$fname[x],value);\n"
+		<<	setDirtyIf(f,"r >= 0")
+		<<	"return r;\n"
 			"}\n"
 			"}\n";
 		return;
@@ -2123,7 +2576,7 @@ void CppGenerator::writeSetByNameR(Generator &G, Field *f)
 				"if (eptr == value)\n"
 				"	$handle_error;\n"
 				"m_$fname[x] = ($typestr) ll;\n"
-				"m_$fname[x] = ($typestr) ll;\n";
+			<<	setDirty(f);
 			writeSetValid(G,f->getValidBit());
 			G <<	"return eptr - value;\n"
 				"}\n"
@@ -2134,49 +2587,49 @@ void CppGenerator::writeSetByNameR(Generator &G, Field *f)
 	switch (t) {
 	case ft_string:
 		G <<	"m_$fname[x] = value;\n"
-			"return m_$(fname)[x].size();\n";
+			"int r = m_$(fname)[x].size();\n";
 		break;
 	case ft_float:
-		G <<	"return parse_ascii_flt(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_flt(&m_$(fname)[x],value);\n";
 		break;
 	case ft_double:
-		G <<	"return parse_ascii_dbl(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_dbl(&m_$(fname)[x],value);\n";
 		break;
 	case ft_int8:
 	case ft_sint8:
 	case ft_sfixed8:
-		G <<	"return parse_ascii_s8(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_s8(&m_$(fname)[x],value);\n";
 		break;
 	case ft_int16:
 	case ft_sint16:
 	case ft_sfixed16:
-		G <<	"return parse_ascii_s16(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_s16(&m_$(fname)[x],value);\n";
 		break;
 	case ft_int32:
 	case ft_sint32:
 	case ft_sfixed32:
-		G <<	"return parse_ascii_s32(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_s32(&m_$(fname)[x],value);\n";
 		break;
 	case ft_int64:
 	case ft_sint64:
 	case ft_sfixed64:
-		G <<	"return parse_ascii_s64(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_s64(&m_$(fname)[x],value);\n";
 		break;
 	case ft_fixed8:
 	case ft_uint8:
-		G <<	"return parse_ascii_u8(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_u8(&m_$(fname)[x],value);\n";
 		break;
 	case ft_uint16:
 	case ft_fixed16:
-		G <<	"return parse_ascii_u16(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_u16(&m_$(fname)[x],value);\n";
 		break;
 	case ft_uint32:
 	case ft_fixed32:
-		G <<	"return parse_ascii_u32(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_u32(&m_$(fname)[x],value);\n";
 		break;
 	case ft_uint64:
 	case ft_fixed64:
-		G <<	"return parse_ascii_u64(&m_$(fname)[x],value);\n";
+		G <<	"int r = parse_ascii_u64(&m_$(fname)[x],value);\n";
 		break;
 	case ft_bool:
 		// vector<bool>::operator[] returns value instead of reference!
@@ -2184,175 +2637,231 @@ void CppGenerator::writeSetByNameR(Generator &G, Field *f)
 			"int r = parse_ascii_bool(&b,value);\n"
 			"if (0 > r)\n"
 			"	$handle_error;\n"
-			"$(field_set)(x,b);\n"
-			"return r;\n";
+			"$(field_set)(x,b);\n";
 		break;
 	case ft_signed:
 	case ft_unsigned:
 	default:
 		abort();
 	}
-	G << "}\n}\n";
+	G <<	setDirtyIf(f,"r >= 0")
+	<<	"return r;\n"
+		"}\n"
+		"}\n";
 }
 
 
-void CppGenerator::writeSetByName(Generator &G, Message *m)
+void CppGenerator::writeSetByNameF(Generator &G, Field *f)
 {
-	if (target->getOption("SetByName").empty())
-		return;
-	if (WithComments)
-		G <<	"/*\n"
-			" * Function for setting an element in dot notation with an ASCII value.\n"
-			" * It will call the specified parse_ascii function for parsing the value.\n"
-			" *\n"
-			" * @return number of bytes successfully parsed or negative value indicating\n"
-			" *         an error.\n"
-			" */\n";
-	G <<	"int $(prefix)$(msg_name)::$(set_by_name)(const char *name, const char *value)\n"
-		"{\n";
-	unsigned n = 0;
-	for (auto i : m->getFields()) {
-		Field *f = i.second;
-		if ((f == 0) || !f->isUsed() || f->isObsolete())
-			continue;
-		uint32_t t = f->getType();
-		if (t == ft_cptr)
-			continue;
-		++n;
-		if (q_repeated == f->getQuantifier()) {
-			if (t == ft_bytes)
-				continue;
-			G.setField(f);
-			writeSetByNameR(G,f);
-			G.setField(0);
-			continue;
-		}
-		G.setField(f);
-		if ((t & ft_filter) == ft_msg) {
-			if (f->getValidBit() >= 0) {
-				G <<	"if (0 == memcmp(name,\"$(fname)\",$fnamelen)) {\n"
-					"if ((name[$fnamelen] == 0) && (value == 0)) {\n"
-					"$field_clear();\n"
-					"return 0;\n"
-					"} else if (name[$fnamelen] == '.') {\n";
-				writeSetValid(G,f->getValidBit());
-			} else {
-				G <<	"if (0 == memcmp(name,\"$(fname)\",$fnamelen)) {\n"
-					"if ((name[$fnamelen] == 0) && (value == 0)) {\n"
-					"m_$fname.clear();\n"
-					"return 0;\n"
-					"} else if (name[$fnamelen] == '.') {\n";
-
-			}
-			G <<	"return m_$(fname).$(set_by_name)(name+$($fnamelen+1),value);\n"
-				"}\n"
-				"}\n";
-			G.setField(0);
-			continue;
-		}
-		G <<	"if (0 == strcmp(name,\"$(fname)\")) {\n";
-		if (q_required != f->getQuantifier()) {
-			G <<	"if (value == 0) {\n"
+	uint32_t t = f->getType();
+	if ((t & ft_filter) == ft_msg) {
+		if (f->getValidBit() >= 0) {
+			G <<	"if (0 == memcmp(name,\"$(fname)\",$fnamelen)) {\n"
+				"if ((name[$fnamelen] == 0) && (value == 0)) {\n"
 				"$field_clear();\n"
 				"return 0;\n"
-				"}\n";
+				"} else if (name[$fnamelen] == '.') {\n";
+			writeSetValid(G,f->getValidBit());
+		} else {
+			G <<	"if (0 == memcmp(name,\"$(fname)\",$fnamelen)) {\n"
+				"if ((name[$fnamelen] == 0) && (value == 0)) {\n"
+				"m_$fname.clear();\n"
+			<<	setDirty(f)
+			<<	"return 0;\n"
+				"} else if (name[$fnamelen] == '.') {\n";
+
 		}
-		if (!f->getParseAsciiFunction().empty()) {
-			G <<	"int r = $parse_ascii(&m_$fname,value);\n"
-				"if (r > 0)\n";
+		G <<	"int r = m_$(fname).$(set_by_name)(name+$($fnamelen+1),value);\n"
+		<<	setDirtyIf(f,"r >= 0")
+		<<	"return r;\n"
+			"}\n"
+			"}\n";
+		return;
+	}
+	G <<	"if (0 == strcmp(name,\"$(fname)\")) {\n";
+	if (q_required != f->getQuantifier()) {
+		G <<	"if (value == 0) {\n"
+			"$field_clear();\n"
+			"return 0;\n"
+			"}\n";
+	}
+	if (!f->getParseAsciiFunction().empty()) {
+		G <<	"int r = $parse_ascii(&m_$fname,value);\n"
+			"if (r > 0)\n";
+		writeSetValid(G,f->getValidBit());
+		G <<	setDirtyIf(f,"r >= 0")
+		<<	"return r;\n"
+			"}\n";
+		return;
+	}
+	if ((t & ft_filter) == ft_enum) {
+		if (target->getFlag("enumnames")) {
+			G <<	"varint_t v;\n"
+				"int r = parse_enum(&v,value);\n"
+				"if (r > 0)\n"
+				"	m_$(fname) = ($(fulltype))v;\n"
+			<<	setDirtyIf(f,"r > 0")
+			<<	"return r;\n"
+				"}\n";
+		} else {
+			G <<	"char *eptr;\n"
+				"long long ll = strtoll(value,&eptr,0);\n"
+				"if (eptr == value)\n"
+				"	$handle_error;\n";
 			writeSetValid(G,f->getValidBit());
-			G <<	"return r;\n"
+			G <<	"m_$fname = ($typestr) ll;\n"
+			<<	setDirty(f)
+			<<	"return eptr - value;\n"
 				"}\n";
-			G.setField(0);
-			continue;
-		}
-		if ((t & ft_filter) == ft_enum) {
-			if (target->getFlag("enumnames")) {
-				G <<	"varint_t v;\n"
-					"int r = parse_enum(&v,value);\n"
-					"if (r > 0)\n"
-					"	m_$(fname) = ($(fulltype))v;\n"
-					"return r;\n"
-					"}\n";
-			} else {
-				G <<	"char *eptr;\n"
-					"long long ll = strtoll(value,&eptr,0);\n"
-					"if (eptr == value)\n"
-					"	$handle_error;\n";
-				writeSetValid(G,f->getValidBit());
-				G <<	"m_$fname = ($typestr) ll;\n"
-					"return eptr - value;\n"
-					"}\n";
-			}
-			G.setField(0);
-			continue;
 		}
-		switch (t) {
-		case ft_string:
-			G <<	"m_$fname = value;\n"
-				"int r = m_$(fname).size();\n";
-			break;
-		case ft_bytes:
-			G <<	"int r = parse_ascii_bytes(m_$(fname),value);\n";
-			break;
-		case ft_float:
-			G <<	"int r = parse_ascii_flt(&m_$(fname),value);\n";
-			break;
-		case ft_double:
-			G <<	"int r = parse_ascii_dbl(&m_$(fname),value);\n";
-			break;
-		case ft_int8:
-		case ft_sint8:
-		case ft_sfixed8:
-			G <<	"int r = parse_ascii_s8(&m_$(fname),value);\n";
-			break;
-		case ft_int16:
-		case ft_sint16:
-		case ft_sfixed16:
-			G <<	"int r = parse_ascii_s16(&m_$(fname),value);\n";
-			break;
-		case ft_int32:
-		case ft_sint32:
-		case ft_sfixed32:
-			G <<	"int r = parse_ascii_s32(&m_$(fname),value);\n";
-			break;
-		case ft_int64:
-		case ft_sint64:
-		case ft_sfixed64:
-			G <<	"int r = parse_ascii_s64(&m_$(fname),value);\n";
-			break;
-		case ft_fixed8:
-		case ft_uint8:
-			G <<	"int r = parse_ascii_u8(&m_$(fname),value);\n";
-			break;
-		case ft_uint16:
-		case ft_fixed16:
-			G <<	"int r = parse_ascii_u16(&m_$(fname),value);\n";
-			break;
-		case ft_uint32:
-		case ft_fixed32:
-			G <<	"int r = parse_ascii_u32(&m_$(fname),value);\n";
-			break;
-		case ft_uint64:
-		case ft_fixed64:
-			G <<	"int r = parse_ascii_u64(&m_$(fname),value);\n";
-			break;
-		case ft_bool:
-			G <<	"int r = parse_ascii_bool(&m_$(fname),value);\n";
-			break;
-		case ft_signed:
-		case ft_unsigned:
-		default:
-			abort();
+		return;
+	}
+	switch (t) {
+	case ft_string:
+		G <<	"m_$fname = value;\n"
+			"int r = m_$(fname).size();\n";
+		break;
+	case ft_bytes:
+		G <<	"int r = parse_ascii_bytes(m_$(fname),value);\n";
+		break;
+	case ft_float:
+		G <<	"int r = parse_ascii_flt(&m_$(fname),value);\n";
+		break;
+	case ft_double:
+		G <<	"int r = parse_ascii_dbl(&m_$(fname),value);\n";
+		break;
+	case ft_int8:
+	case ft_sint8:
+	case ft_sfixed8:
+		G <<	"int r = parse_ascii_s8(&m_$(fname),value);\n";
+		break;
+	case ft_int16:
+	case ft_sint16:
+	case ft_sfixed16:
+		G <<	"int r = parse_ascii_s16(&m_$(fname),value);\n";
+		break;
+	case ft_int32:
+	case ft_sint32:
+	case ft_sfixed32:
+		G <<	"int r = parse_ascii_s32(&m_$(fname),value);\n";
+		break;
+	case ft_int64:
+	case ft_sint64:
+	case ft_sfixed64:
+		G <<	"int r = parse_ascii_s64(&m_$(fname),value);\n";
+		break;
+	case ft_fixed8:
+	case ft_uint8:
+		G <<	"int r = parse_ascii_u8(&m_$(fname),value);\n";
+		break;
+	case ft_uint16:
+	case ft_fixed16:
+		G <<	"int r = parse_ascii_u16(&m_$(fname),value);\n";
+		break;
+	case ft_uint32:
+	case ft_fixed32:
+		G <<	"int r = parse_ascii_u32(&m_$(fname),value);\n";
+		break;
+	case ft_uint64:
+	case ft_fixed64:
+		G <<	"int r = parse_ascii_u64(&m_$(fname),value);\n";
+		break;
+	case ft_bool:
+		G <<	"int r = parse_ascii_bool(&m_$(fname),value);\n";
+		break;
+	case ft_signed:
+	case ft_unsigned:
+	default:
+		abort();
+	}
+	int v = f->getValidBit();
+	if (v >= 0) {
+		G << "if (r > 0)\n";
+		writeSetValid(G,v);
+	}
+	G <<	setDirtyIf(f,"r >= 0")
+	<<	"return r;\n"
+		"}\n";
+}
+
+
+void CppGenerator::writeSetByNameDispatch(Generator &G, const vector<Field *> &fields, size_t len)
+{
+	if (fields.size() == 1) {
+		Field *f = fields[0];
+		G.setField(f);
+		if (q_repeated == f->getQuantifier())
+			writeSetByNameR(G,f);
+		else
+			writeSetByNameF(G,f);
+		G.setField(0);
+		G <<	"break;\n";
+		return;
+	}
+	// switch on the character position with most distinct values
+	size_t pos = 0, best = 0;
+	for (size_t p = 0; p != len; ++p) {
+		set<char> chars;
+		for (Field *f : fields)
+			chars.insert(f->getName()[p]);
+		if (chars.size() > best) {
+			best = chars.size();
+			pos = p;
 		}
-		int v = f->getValidBit();
-		if (v >= 0) {
-			G << "if (r > 0)\n";
-			writeSetValid(G,v);
+	}
+	map<char,vector<Field *>> sub;
+	for (Field *f : fields)
+		sub[f->getName()[pos]].push_back(f);
+	G <<	"switch (name[" << pos << "]) {\n";
+	for (const auto &c : sub) {
+		G <<	"case '" << c.first << "':\n";
+		writeSetByNameDispatch(G,c.second,len);
+	}
+	G <<	"}\n"
+		"break;\n";
+}
+
+
+void CppGenerator::writeSetByName(Generator &G, Message *m)
+{
+	if (target->getOption("SetByName").empty())
+		return;
+	if (WithComments)
+		G <<	"/*\n"
+			" * Function for setting an element in dot notation with an ASCII value.\n"
+			" * It will call the specified parse_ascii function for parsing the value.\n"
+			" * The field is selected by the length of its name and the characters\n"
+			" * that distinguish it from other names of the same length, so that\n"
+			" * only one name comparison is needed.\n"
+			" *\n"
+			" * @return number of bytes successfully parsed or negative value indicating\n"
+			" *         an error.\n"
+			" */\n";
+	G <<	"int $(prefix)$(msg_name)::$(set_by_name)(const char *name, const char *value)\n"
+		"{\n";
+	writeLazyAccess(G,m,"");
+	// group the fields by the length of their name
+	map<size_t,vector<Field *>> names;
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed() || f->isObsolete())
+			continue;
+		uint32_t t = f->getType();
+		if (t == ft_cptr)
+			continue;
+		if (((t == ft_string) || (t == ft_bytes)) && (0 == strcmp(f->getTypeName(),"BufView")))
+			continue;	// a view cannot keep the value beyond the call
+		if ((q_repeated == f->getQuantifier()) && (t == ft_bytes))
+			continue;
+		names[strlen(f->getName())].push_back(f);
+	}
+	if (!names.empty()) {
+		G <<	"switch (strcspn(name,\".[\")) {\n";
+		for (const auto &n : names) {
+			G <<	"case " << n.first << ":\n";
+			writeSetByNameDispatch(G,n.second,n.first);
 		}
-		G <<	"return r;\n"
-			"}\n";
-		G.setField(0);
+		G <<	"}\n";
 	}
 	G <<	"$handle_error;\n}\n\n";
 }
@@ -2369,12 +2878,16 @@ void CppGenerator::writeClear(Generator &G, Field *f)
 			" * It will reset the value to the default value.\n"
 			" */\n";
 	G <<	"$(inline)void $(prefix)$(msg_name)::$(field_clear)()\n"
-		"{\n";
+		"{\n"
+	<<	setDirty(f);
 	uint32_t type = f->getType();
 	int vbit = f->getValidBit();
 	if (vbit >= 0) {
 		writeClearValid(G,vbit);
 	}
+	if (f->isLazy())
+		G <<	"lazy_$(fname) = 0;\n"
+			"lazyused_$(fname) = false;\n";
 	if ((q == q_repeated) || ((type & ft_filter) == ft_msg)) {
 		G << "m_$(fname).clear();";
 	} else if (const char *defStr = f->getDefaultValue()) {
@@ -2481,7 +2994,7 @@ void CppGenerator::writeCalcSize(Generator &G, Field *f)
 				G <<	"size_t $(fname)_dl = 0;\n"
 					"for (size_t x = 0, y = $(field_size); x < y; ++x)\n"
 					"$(fname)_dl += $(wiresize_s)((int64_t)$(field_value));\n"
-					"r += $(fname)_dl + $(wiresize_s)($(fname)_dl) /* data length */" << tstr << ";\n";
+					"r += $(fname)_dl + $(wiresize_u)($(fname)_dl) /* data length */" << tstr << ";\n";
 				break;
 			default:
 				assert((type & ft_filter) == ft_enum);
@@ -2594,6 +3107,12 @@ void CppGenerator::writeCalcSize(Generator &G, Field *f)
 		if (f->isVirtual())
 			G <<	"size_t $(fname)_s = $(field_get)().$calcSize();\n"
 				"r += $(fname)_s + $(wiresize_u)($(fname)_s)" << tstr << ";\n";
+		else if (f->isLazy() && PaddedMsgSize)
+			G <<	"size_t $(fname)_s = lazy_$(fname) ? lazysize_$(fname) : m_$(fname).$calcSize();\n"
+				"r += $(fname)_s + sizeof(varint_t)*8/7+1" << tstr << ";\n";
+		else if (f->isLazy())
+			G <<	"size_t $(fname)_s = lazy_$(fname) ? lazysize_$(fname) : m_$(fname).$calcSize();\n"
+				"r += $(fname)_s + $(wiresize_u)($(fname)_s)" << tstr << ";\n";
 		else if (PaddedMsgSize)
 			G <<	"size_t $(fname)_s = m_$(fname).$calcSize();\n"
 				"r += $(fname)_s + sizeof(varint_t)*8/7+1" << tstr << ";\n";
@@ -2702,6 +3221,8 @@ void CppGenerator::writeCalcSize(Generator &G, Message *m)
 		if (!(f->hasFixedSize() && (f->getQuantifier() == 1)))
 			writeCalcSize(G,f);
 	}
+	if (CachedSize)
+		G <<	"p_cachedsize = r;\n";
 	G <<	"return r;\n"
 		"}\n"
 		"\n";
@@ -2824,6 +3345,55 @@ void CppGenerator::decodeMessage(Generator &G, Field *f)
 }
 
 
+static void writeLazyFraming(Generator &G, const char *len)
+{
+	// errors of decoding on access cannot be returned, so check the
+	// framing of the len bytes at a when recording them
+	G <<	"const uint8_t *x = a, *xe = a + " << len << ";\n"
+		"while (x < xe) {\n"
+		"varint_t fid;\n"
+		"int fn = read_varint(x,xe-x,&fid);\n"
+		"if (fn <= 0)\n"
+		"	$handle_error;\n"
+		"x += fn;\n"
+		"ssize_t xn = skip_content(x,xe-x,fid&7);\n"
+		"if (xn <= 0)\n"
+		"	$handle_error;\n"
+		"x += xn;\n"
+		"}\n";
+}
+
+
+void CppGenerator::decodeLazy(Generator &G, Field *f)
+{
+	// only record the location, decoding happens on first access
+	// data for a field that is in use or has been recorded before
+	// must be merged, so that it is not lost on serialization
+	G <<	"{\n"
+		"varint_t v;\n"
+		"int n = read_varint(a,e-a,&v);\n"
+		"if ((n <= 0) || (v > (varint_t)(e-a-n)))\n"
+		"	$handle_error;\n"
+		"a += n;\n"
+		"if (lazy_$(fname) || lazyused_$(fname)) {\n"
+		"lazy_decode_$(fname)();\n"
+		"if (v != 0) {\n"
+		"n = m_$(fname).$(fromMemory)((const uint8_t*)a,v);\n"
+		"if (n < 0)\n"
+		"return n;\n"
+		"if (n != (ssize_t)v)\n"
+		"	$handle_error;\n"
+		"}\n"
+		"} else {\n";
+	writeLazyFraming(G,"v");
+	G <<	"lazy_$(fname) = a;\n"
+		"lazysize_$(fname) = v;\n"
+		"}\n"
+		"a += v;\n"
+		"}\n";
+}
+
+
 void CppGenerator::decodeByteArray(Generator &G, Field *f)
 {
 	if ((optmode == optspeed) || (target->getOption("stringtype") == "C")) {
@@ -2857,8 +3427,10 @@ static void writeSkipContent(Generator &G, wiretype_t t)
 {
 	switch (t) {
 	case wt_varint:
-		G <<	"while ((*a & 0x80) && (a <= e))\n"
-			"	++a;\n";
+		G <<	"do {\n"
+			"if (a >= e)\n"
+			"	$handle_error;\n"
+			"} while (*a++ & 0x80);\n";
 		break;
 	case wt_64bit:
 		G << "a += 8;\n";
@@ -2873,7 +3445,11 @@ static void writeSkipContent(Generator &G, wiretype_t t)
 		G << "++a;\n";
 		break;
 	default:
-		G << "{\n"
+		G <<	"if (a >= e)\n"
+			"	$handle_error;\n"
+			"if (*a < 0x80) {\n"
+			"a += *a + 1;\n"
+			"} else {\n"
 			"varint_t v;\n"
 			"unsigned l = read_varint(a,e-a,&v);\n"
 			"if (0 == l)\n"
@@ -2881,109 +3457,221 @@ static void writeSkipContent(Generator &G, wiretype_t t)
 			"a += l + v;\n"
 			"}\n";
 	}
-	G <<	"if (a >= e)\n"
+	G <<	"if (a > e)\n"
 		"	$handle_error;\n"
 		"break;\n";
 }
 
 
-void CppGenerator::writeFromMemory(Generator &G, Field *f)
+static bool hasBulkPackedDecode(Field *f)
 {
-	G.setField(f);
+	if (f->isVirtual())
+		return false;
+	switch (f->getTypeClass()) {
+	case ft_fixed8:
+	case ft_sfixed8:
+	case ft_fixed16:
+	case ft_sfixed16:
+	case ft_fixed32:
+	case ft_sfixed32:
+	case ft_float:
+	case ft_fixed64:
+	case ft_sfixed64:
+	case ft_double:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+void CppGenerator::decodePackedFixed(Generator &G, Field *f)
+{
+	// element count is known from the length prefix:
+	// resize once and copy the elements in bulk
 	uint32_t type = f->getTypeClass();
-	uint32_t id = f->getId();
-	if (!f->isUsed() || f->isObsolete()) {
-		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr\n";
-		writeSkipContent(G,f->getEncoding());
-		G.setField(0);
+	G <<	"if ((v % sizeof($typestr)) || (v > (varint_t)(e-a)))\n"
+		"	$handle_error;\n"
+		"size_t x0 = $(m_field).size();\n"
+		"size_t ne = v / sizeof($typestr);\n";
+	if (unsigned as = f->getArraySize())
+		G <<	"if (x0 + ne > " << as << ")\n"
+			"	$handle_error;\n";
+	G <<	"$(m_field).resize(x0+ne);\n";
+	if ((Endian == little_endian) || (type == ft_fixed8) || (type == ft_sfixed8)) {
+		G <<	"if (v != 0)\n"
+			"memcpy(&$(m_field)[x0],a,v);\n"
+			"a += v;\n";
 		return;
 	}
-	if (f->isPacked()) {
-		G.setVariableHex("field_tag",(int64_t)id<<3|2);
-		G <<	"case $(field_tag): {\t// $(fname) id $(field_id), packed $(typestr)[] coding 2\n"
-			"varint_t v;\n"
-			"int n = read_varint(a,e-a,&v);\t// length of packed\n"
-			"if (n <= 0)\n"
-			"	$handle_error;\n"
-			"a += n;\n"
-			"const uint8_t *ae = a + v;\n"
-			"do {\n";
-		switch (type) {
-		case ft_msg:
-		case ft_bytes:
-		case ft_string:
-		case ft_cptr:
-		default:
-			abort();
-			break;
-		case ft_unsigned:
-		case ft_int:
-		case ft_enum:
-		case ft_int8:
-		case ft_uint8:
-		case ft_int16:
-		case ft_uint16:
-		case ft_int32:
-		case ft_uint32:
-		case ft_int64:
-		case ft_uint64:
-			decodeVarint(G,f);
-			break;
-		case ft_signed:
-		case ft_sint8:
-		case ft_sint16:
-		case ft_sint32:
-		case ft_sint64:
-			decodeSVarint(G,f);
-			break;
-		case ft_bool:
-		case ft_fixed8:
-		case ft_sfixed8:
-			decode8bit(G,f);
-			break;
-		case ft_fixed16:
-		case ft_sfixed16:
-			decode16bit(G,f);
-			break;
-		case ft_fixed32:
-		case ft_sfixed32:
-		case ft_float:
-			decode32bit(G,f);
-			break;
-		case ft_fixed64:
-		case ft_sfixed64:
-		case ft_double:
-			decode64bit(G,f);
-			break;
-		}
-		G <<	"} while (a < ae);\n"
-			"} break;\n";
-		uint32_t enc = f->getEncoding();
-		if (enc == wt_lenpfx) {
-			G.setField(0);
-			return;
-		}
-		G.setVariableHex("field_tag",(int64_t)id<<3|enc);
-	}
-	int vbit = f->getValidBit();
 	switch (type) {
-	case ft_msg:
-		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding byte[]\n";
-		decodeMessage(G,f);
-		if (vbit != -1)
-			writeSetValid(G,vbit);
+	case ft_fixed16:
+	case ft_sfixed16:
+		G <<	"for (size_t x = x0; x != x0+ne; ++x, a += 2)\n"
+			"$(m_field)[x] = ($typestr) read_u16(a);\n";
 		break;
-	case ft_bytes:
-	case ft_string:
-		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding byte[]\n";
-		decodeByteArray(G,f);
-		if (vbit != -1)
-			writeSetValid(G,vbit);
+	case ft_fixed32:
+	case ft_sfixed32:
+		G <<	"for (size_t x = x0; x != x0+ne; ++x, a += 4)\n"
+			"$(m_field)[x] = ($typestr) read_u32(a);\n";
 		break;
-	case ft_cptr:
-		G <<	"case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding byte[]\n"
-			"{\n"
-			"varint_t v;\n"
+	case ft_float:
+		G <<	"for (size_t x = x0; x != x0+ne; ++x, a += 4)\n"
+			"$(m_field)[x] = read_float(a);\n";
+		break;
+	case ft_fixed64:
+	case ft_sfixed64:
+		G <<	"for (size_t x = x0; x != x0+ne; ++x, a += 8)\n"
+			"$(m_field)[x] = ($typestr) read_u64(a);\n";
+		break;
+	case ft_double:
+		G <<	"for (size_t x = x0; x != x0+ne; ++x, a += 8)\n"
+			"$(m_field)[x] = read_double(a);\n";
+		break;
+	default:
+		abort();
+	}
+}
+
+
+static bool hasPackedVarint(Field *f)
+{
+	if (f->isVirtual())
+		return false;
+	switch (f->getTypeClass()) {
+	case ft_unsigned:
+	case ft_int:
+	case ft_enum:
+	case ft_int8:
+	case ft_uint8:
+	case ft_int16:
+	case ft_uint16:
+	case ft_int32:
+	case ft_uint32:
+	case ft_int64:
+	case ft_uint64:
+	case ft_signed:
+	case ft_sint8:
+	case ft_sint16:
+	case ft_sint32:
+	case ft_sint64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+void CppGenerator::decodePackedCount(Generator &G, Field *f)
+{
+	// every varint ends with a byte that has the MSB cleared:
+	// count them to reserve the vector or check the array capacity
+	// before decoding
+	G <<	"if (v > (varint_t)(e-a))\n"
+		"	$handle_error;\n"
+		"if ((v != 0) && (ae[-1] & 0x80))\n"
+		"	$handle_error;\n"
+		"size_t ne = 0;\n"
+		"for (const uint8_t *x = a; x != ae; ++x)\n"
+		"	ne += (*x >> 7) ^ 1;\n";
+	if (unsigned as = f->getArraySize())
+		G <<	"if ($(m_field).size() + ne > " << as << ")\n"
+			"	$handle_error;\n";
+	else
+		G <<	"$(m_field).reserve($(m_field).size()+ne);\n";
+}
+
+
+void CppGenerator::decodePacked(Generator &G, Field *f)
+{
+	G <<	"varint_t v;\n"
+		"int n = read_varint(a,e-a,&v);\t// length of packed\n"
+		"if (n <= 0)\n"
+		"	$handle_error;\n"
+		"a += n;\n";
+	if (hasBulkPackedDecode(f)) {
+		decodePackedFixed(G,f);
+		return;
+	}
+	G <<	"const uint8_t *ae = a + v;\n";
+	if (hasPackedVarint(f))
+		decodePackedCount(G,f);
+	G <<	"do {\n";
+	switch (f->getTypeClass()) {
+	case ft_msg:
+	case ft_bytes:
+	case ft_string:
+	case ft_cptr:
+	default:
+		abort();
+		break;
+	case ft_unsigned:
+	case ft_int:
+	case ft_enum:
+	case ft_int8:
+	case ft_uint8:
+	case ft_int16:
+	case ft_uint16:
+	case ft_int32:
+	case ft_uint32:
+	case ft_int64:
+	case ft_uint64:
+		decodeVarint(G,f);
+		break;
+	case ft_signed:
+	case ft_sint8:
+	case ft_sint16:
+	case ft_sint32:
+	case ft_sint64:
+		decodeSVarint(G,f);
+		break;
+	case ft_bool:
+	case ft_fixed8:
+	case ft_sfixed8:
+		decode8bit(G,f);
+		break;
+	case ft_fixed16:
+	case ft_sfixed16:
+		decode16bit(G,f);
+		break;
+	case ft_fixed32:
+	case ft_sfixed32:
+	case ft_float:
+		decode32bit(G,f);
+		break;
+	case ft_fixed64:
+	case ft_sfixed64:
+	case ft_double:
+		decode64bit(G,f);
+		break;
+	}
+	G <<	"} while (a < ae);\n";
+}
+
+
+void CppGenerator::decodeField(Generator &G, Field *f)
+{
+	// decodes the value of the default encoding, the tag has
+	// already been consumed
+	int vbit = f->getValidBit();
+	switch (f->getTypeClass()) {
+	case ft_msg:
+		if (f->isLazy())
+			decodeLazy(G,f);
+		else
+			decodeMessage(G,f);
+		if (vbit != -1)
+			writeSetValid(G,vbit);
+		break;
+	case ft_bytes:
+	case ft_string:
+		decodeByteArray(G,f);
+		if (vbit != -1)
+			writeSetValid(G,vbit);
+		break;
+	case ft_cptr:
+		G <<	"{\n"
+			"varint_t v;\n"
 			"int n = read_varint(a,e-a,&v);\n"
 			"a += n;\n"
 			"if ((n <= 0) || (a+v > e))\n"
@@ -3005,10 +3693,87 @@ void CppGenerator::writeFromMemory(Generator &G, Field *f)
 	case ft_int32:
 	case ft_uint32:
 	case ft_int64:
+	case ft_uint64:
+		decodeVarint(G,f);
+		break;
+	case ft_signed:
+	case ft_sint8:
+	case ft_sint16:
+	case ft_sint32:
+	case ft_sint64:
+		decodeSVarint(G,f);
+		break;
+	case ft_bool:
+	case ft_fixed8:
+	case ft_sfixed8:
+		decode8bit(G,f);
+		break;
+	case ft_fixed16:
+	case ft_sfixed16:
+		decode16bit(G,f);
+		break;
+	case ft_fixed32:
+	case ft_sfixed32:
+	case ft_float:
+		decode32bit(G,f);
+		break;
+	case ft_fixed64:
+	case ft_sfixed64:
+	case ft_double:
+		decode64bit(G,f);
+		break;
+	default:
+		abort();
+	}
+}
+
+
+void CppGenerator::writeFromMemory(Generator &G, Field *f)
+{
+	G.setField(f);
+	uint32_t type = f->getTypeClass();
+	uint32_t id = f->getId();
+	if (!f->isUsed() || f->isObsolete()) {
+		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr\n";
+		writeSkipContent(G,f->getEncoding());
+		G.setField(0);
+		return;
+	}
+	if (f->isPacked()) {
+		G.setVariableHex("field_tag",(int64_t)id<<3|2);
+		G <<	"case $(field_tag): {\t// $(fname) id $(field_id), packed $(typestr)[] coding 2\n";
+		decodePacked(G,f);
+		G <<	"} break;\n";
+		// unpacked elements are also accepted
+		uint32_t enc = f->getElementEncoding();
+		if (enc == wt_lenpfx) {
+			G.setField(0);
+			return;
+		}
+		G.setVariableHex("field_tag",(int64_t)id<<3|enc);
+	}
+	switch (type) {
+	case ft_msg:
+	case ft_bytes:
+	case ft_string:
+	case ft_cptr:
+		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding byte[]\n";
+		decodeField(G,f);
+		break;
+	case ft_unsigned:
+	case ft_int:
+	case ft_enum:
+	case ft_int8:
+	case ft_uint8:
+	case ft_int16:
+	case ft_uint16:
+	case ft_int32:
+	case ft_uint32:
+	case ft_int64:
 	case ft_uint64:
 		G.setVariableHex("field_tag",(int64_t)id<<3|wt_varint);
 		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding varint\n";
-		decodeVarint(G,f);
+		decodeField(G,f);
 		if (target->getFlag("FlexDecoding")) {
 			G << "break;\n";
 			G.setVariableHex("field_tag",(int64_t)id<<3|wt_8bit);
@@ -3034,30 +3799,30 @@ void CppGenerator::writeFromMemory(Generator &G, Field *f)
 	case ft_sint32:
 	case ft_sint64:
 		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding signed varint\n";
-		decodeSVarint(G,f);
+		decodeField(G,f);
 		break;
 	case ft_bool:
 	case ft_fixed8:
 	case ft_sfixed8:
 		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding 8bit\n";
-		decode8bit(G,f);
+		decodeField(G,f);
 		break;
 	case ft_fixed16:
 	case ft_sfixed16:
 		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding 16bit\n";
-		decode16bit(G,f);
+		decodeField(G,f);
 		break;
 	case ft_fixed32:
 	case ft_sfixed32:
 	case ft_float:
 		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding 32bit\n";
-		decode32bit(G,f);
+		decodeField(G,f);
 		break;
 	case ft_fixed64:
 	case ft_sfixed64:
 	case ft_double:
 		G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding 64bit\n";
-		decode64bit(G,f);
+		decodeField(G,f);
 		break;
 	default:
 		abort();
@@ -3067,6 +3832,79 @@ void CppGenerator::writeFromMemory(Generator &G, Field *f)
 }
 
 
+void CppGenerator::writeTagPrediction(Generator &G, Message *m)
+{
+	// Fields are serialized in ascending order of their ids. So try
+	// to decode them in this order by comparing the raw tag bytes,
+	// before falling back to the generic loop with the tag switch.
+	int term = terminatorByte();
+	if (WithComments)
+		G << "// fast path: fields in expected order\n";
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed() || f->isObsolete() || f->isDeprecated())
+			continue;
+		wiretype_t enc = f->getEncoding();
+		switch (f->getTypeClass()) {
+		case ft_unsigned:
+		case ft_int:
+		case ft_enum:
+		case ft_int8:
+		case ft_uint8:
+		case ft_int16:
+		case ft_uint16:
+		case ft_int32:
+		case ft_uint32:
+		case ft_int64:
+		case ft_uint64:
+			// decoder only expects varint as default encoding
+			if (!f->isPacked() && (enc != wt_varint))
+				continue;
+			break;
+		default:
+			;
+		}
+		unsigned xid = (f->getId() << 3) | enc;
+		vector<unsigned> tag;
+		do {
+			tag.push_back((xid & 0x7f) | (xid > 0x7f ? 0x80 : 0));
+			xid >>= 7;
+		} while (xid);
+		// the generic loop checks for the terminator first
+		if ((term >= 0) && (tag[0] == (unsigned)term))
+			continue;
+		G.setField(f);
+		if (f->isRepeated() && !f->isPacked())
+			G << "while (";
+		else
+			G << "if (";
+		if (tag.size() == 1)
+			G << "(a < e)";
+		else
+			G << "((e-a) >= " << tag.size() << ")";
+		char buf[32];
+		for (size_t x = 0, n = tag.size(); x != n; ++x) {
+			sprintf(buf," && (a[%u] == 0x%x)",(unsigned)x,tag[x]);
+			G << buf;
+		}
+		G << ") {\t// $(fname) id $(field_id)\n";
+		if (tag.size() == 1)
+			G << "++a;\n";
+		else
+			G << "a += " << tag.size() << ";\n";
+		if (f->isPacked()) {
+			G << "{\n";
+			decodePacked(G,f);
+			G << "}\n";
+		} else {
+			decodeField(G,f);
+		}
+		G << "}\n";
+		G.setField(0);
+	}
+}
+
+
 void CppGenerator::writeTagToMemory(Generator &G, Field *f, unsigned fixedlen)
 {
 	// fixedlen reserves space in memory for the field value
@@ -3410,6 +4248,23 @@ void CppGenerator::writeToMemory(Generator &G, Field *f)
 			"a += 2;\n";
 		break;
 	case wt_msg: 	// length delimited message
+		if (f->isLazy()) {
+			// emit data that has not been decoded verbatim
+			G <<	"if (lazy_$(fname)) {\n";
+			if (PaddedMsgSize)
+				G <<	"if ((e-a) < (ssize_t)(sizeof(varint_t)*8/7+1+lazysize_$(fname)))\n"
+					"	$handle_error;\n"
+					"place_varint(a,lazysize_$(fname));\n"
+					"a += sizeof(varint_t)*8/7+1;\n";
+			else
+				G <<	"n = write_varint(a,e-a,lazysize_$(fname));\n"
+					"a += n;\n"
+					"if ((n <= 0) || ((ssize_t)lazysize_$(fname) > (e-a)))\n"
+					"	$handle_error;\n";
+			G <<	"memcpy(a,lazy_$(fname),lazysize_$(fname));\n"
+				"a += lazysize_$(fname);\n"
+				"} else {\n";
+		}
 		if (PaddedMsgSize) {
 			G <<	"if ((e-a) < (ssize_t)(sizeof(varint_t)*8/7+1))\n"
 				"	$handle_error;\n"
@@ -3420,16 +4275,26 @@ void CppGenerator::writeToMemory(Generator &G, Field *f)
 				"a += sizeof(varint_t)*8/7+1;\n"
 				"a += n;\n";
 		} else {
-			G <<	"ssize_t $(fname)_ws = $(field_value).$calcSize();\n"
-				"n = write_varint(a,e-a,$(fname)_ws);\n"
+			if (CachedSize && !f->isVirtual())
+				G <<	"ssize_t $(fname)_ws = $(field_value).cachedSize();\n";
+			else
+				G <<	"ssize_t $(fname)_ws = $(field_value).$calcSize();\n";
+			G <<	"n = write_varint(a,e-a,$(fname)_ws);\n"
 				"a += n;\n"
 				"if ((n <= 0) || ($(fname)_ws > (e-a)))\n"
 				"	$handle_error;\n"
-				"n = $(field_value).$toMemory(a,e-a);\n"
-				"a += n;\n";
-			if (Asserts)
+				"n = $(field_value).$toMemory(a,e-a);\n";
+			if (CachedSize && !f->isVirtual()) {
+				// a stale cached size must not yield a corrupt length prefix
+				G <<	"if (n != $(fname)_ws)\n"
+					"	$handle_error;\n";
+			} else if (Asserts) {
 				G << "assert(n == $(fname)_ws);\n";
+			}
+			G <<	"a += n;\n";
 		}
+		if (f->isLazy())
+			G << "}\n";
 		break;
 	case wt_lenpfx:	// length delimited byte array or string
 		if (type == ft_cptr) {
@@ -3486,6 +4351,30 @@ void CppGenerator::writeToMemory(Generator &G, Field *f)
 }
 
 
+void CppGenerator::writeMsgSizeToX(Generator &G, const char *size)
+{
+	string s;
+	if (PaddedMsgSize) {
+		// full length varint as calculated by calcSize
+		s =	"{\n"
+			"varint_t l = ";
+		s +=	size;
+		s +=	";\n"
+			"for (unsigned i = 0; i < sizeof(varint_t)*8/7; ++i) {\n"
+			"$wireput((l & 0x7f) | 0x80);\n"
+			"l >>= 7;\n"
+			"}\n"
+			"$wireput(l);\n"
+			"}\n";
+	} else {
+		s = "$write_varint(";
+		s += size;
+		s += ");\n";
+	}
+	G << s;
+}
+
+
 void CppGenerator::writeToX(Generator &G, Field *f)
 {
 	if (f->isDeprecated() || f->isObsolete()) {
@@ -3603,10 +4492,21 @@ void CppGenerator::writeToX(Generator &G, Field *f)
 		G <<	"$(u16_wire($(field_value)));\n";
 		break;
 	case wt_lenpfx:	// length delimited message, byte array or string
+		if (f->isLazy()) {
+			G <<	"if (lazy_$(fname)) {\n";
+			writeMsgSizeToX(G,"lazysize_$(fname)");
+			G <<	"$write_bytes(lazy_$(fname),lazysize_$(fname));\n"
+				"} else {\n";
+		}
 		if ((type & ft_filter) == ft_msg) {
-			G <<	"$write_varint($(field_value).$calcSize());\n"
-				"$(field_value).$(toX)($putarg);\n";
-		} else if (type == ft_cptr) {
+			if (CachedSize && !f->isVirtual())
+				writeMsgSizeToX(G,"$(field_value).cachedSize()");
+			else
+				writeMsgSizeToX(G,"$(field_value).$calcSize()");
+			G <<	"$(field_value).$(toX)($putarg);\n";
+			if (f->isLazy())
+				G << "}\n";
+		} else if (type == ft_cptr) {
 			G <<	"if ($(field_value)) {\n"
 				"	size_t $(fname)_s = strlen($(field_value)) + 1;\n"
 			 	"	$write_varint($(fname)_s);\n"
@@ -3651,12 +4551,14 @@ void CppGenerator::writeFromMemory(Generator &G, Message *m)
 		"const uint8_t *e = a + s;\n";
 	if (Debug)
 		G << "std::cout << \"$(msg_fullname)::$(fromMemory)(\" << (void*)b << \", \" << s << \")\\n\";\n";
+	if (useFixedLayout(m))
+		writeFromMemoryFixed(G,m);
+	if (TagPrediction)
+		writeTagPrediction(G,m);
 	G <<	"while (a < e) {\n"
 		"varint_t fid;\n";
-	const string &Terminator = target->getOption("Terminator");
-	if ((Terminator == "ff") || (Terminator == "0xff"))
-		G <<	"if (*a == 0xff)\t// 0xff terminator\n"
-			"break;\n";
+	int term = terminatorByte();
+	writeTerminatorCheck(G);
 	G <<	"int fn = read_varint(a,e-a,&fid);\n"
 		"if (fn <= 0)\n"
 		"	$handle_error;\n"
@@ -3711,17 +4613,30 @@ void CppGenerator::writeFromMemory(Generator &G, Message *m)
 				"}\n";
 		}
 	}
-	if ((Terminator == "null") || (Terminator == "0x0") || (Terminator == "0")) {
-		if (hasNullId) 
-			error("request to handle null termination, but null-tag exists");
-		G <<	"case 0:\t// terminate on null byte\n"
-			"	break;\n";
-	}
+	if ((term == 0) && hasNullId)
+		error("request to handle null termination, but null-tag exists");
 	G <<	"default:\n";
 	if (target->getOption("UnknownField") == "assert") {
 		if (WithComments)
 			G << "// unknown field (option unknown=assert)\n";
 		G << "assert(0);\n";
+	} else if ((target->getOption("UnknownField") == "skip") && (optmode == optspeed) && (term < 0)) {
+		if (WithComments)
+			G << "// unknown field (option unknown=skip), skip all following fields of newer versions\n";
+		// fields above the highest id of the dispatch are unknown
+		unsigned maxid = 0;
+		for (auto i : m->getFields()) {
+			Field *f = i.second;
+			if ((f != 0) && f->isUsed() && !f->isObsolete() && (f->getId() > maxid))
+				maxid = f->getId();
+		}
+		G <<	"{\n"
+			"	ssize_t s = skip_fields(a,e-a,fid," << maxid << ");\n"
+			"	if (s <= 0)\n"
+			"		$handle_error;\n"
+			"	a += s;\n"
+			"	break;\n"
+			"}\n";
 	} else if (target->getOption("UnknownField") == "skip") {
 		if (WithComments)
 			G << "// unknown field (option unknown=skip)\n";
@@ -3736,7 +4651,7 @@ void CppGenerator::writeFromMemory(Generator &G, Message *m)
 		fatal("unable to handle option unknown with value %s",target->getOption("UnknownField").c_str());
 	G <<	"}\n"
 		"}\n";
-	if (Asserts)
+	if (Asserts && (term < 0))
 		G << "assert((a-(const uint8_t *)b) == s);\n";
 	G <<	"if (a > e)\n"
 		"	$handle_error;\n"
@@ -3746,296 +4661,2310 @@ void CppGenerator::writeFromMemory(Generator &G, Message *m)
 }
 
 
-void CppGenerator::writeToMemory(Generator &G, Message *m)
+static void writeSkipField(Generator &G)
 {
-	G <<	"ssize_t $(prefix)$(msg_name)::$toMemory(uint8_t *b, ssize_t s) const\n"
-		"{\n";
-	if (Debug)
-		G << "std::cout << \"$(prefix)$(msg_name)::$toMemory(\" << (void*)b << \", \" << s << \")\\n\";\n";
-	if (Asserts)
-		G << "assert(s >= 0);\n";
-	G <<	"uint8_t *a = b, *e = b + s;\n";
-	bool needN = false;
-	auto fields = m->getFields();
-	if (optmode == optspeed) {
-		for (auto i : fields) {
-			Field *f = i.second;
-			if ((f == 0) || (!f->isUsed()) || f->isDeprecated() || f->isObsolete())
-				continue;
-			if (!f->hasFixedSize() || (f->isRepeated() && f->isPacked())) {
-				needN = true;
-				break;
-			}
-		}
-	} else if (optmode == optsize) {
-		for (auto i : fields) {
-			Field *f = i.second;
-			if ((f == 0) || (!f->isUsed()) || f->isDeprecated() || f->isObsolete())
-				continue;
-			if ((f->getTagSize() > 2) || !f->hasFixedSize() || (f->isRepeated() && f->isPacked())) {
-				needN = true;
-				break;
-			}
+	// skip the content of field fid at a according to its wire type
+	G <<	"{\n"
+		"ssize_t n = skip_content(a,e-a,fid&7);\n"
+		"if (n <= 0)\n"
+		"	$handle_error;\n"
+		"a += n;\n"
+		"}\n";
+}
+
+
+void CppGenerator::writeFromMemoryMask(Generator &G, Message *m)
+{
+	// Runs of selected fields are passed to the regular fromMemory.
+	// Unselected fields are skipped according to their wire type.
+	G <<	"ssize_t $(prefix)$(msg_name)::$(fromMemory)(const void *b, ssize_t s, const FieldMask &fm)\n"
+		"{\n"
+		"const uint8_t *a = (const uint8_t *)b;\n"
+		"const uint8_t *e = a + s;\n"
+		"const uint8_t *r = a;\t// start of run of selected fields\n"
+		"while (a < e) {\n"
+		"const uint8_t *f = a;\n"
+		"varint_t fid;\n"
+		"int fn = read_varint(a,e-a,&fid);\n"
+		"if (fn <= 0)\n"
+		"	$handle_error;\n"
+		"a += fn;\n"
+		"if (a >= e)\n"
+		"	$handle_error;\n";
+	writeSkipField(G);
+	G <<	"if (fm.isSet((unsigned)(fid >> 3)))\n"
+		"continue;\n"
+		"if (r != f) {\n"
+		"ssize_t n = $(fromMemory)(r,f-r);\n"
+		"if (n < 0)\n"
+		"return n;\n"
+		"}\n"
+		"r = a;\n"
+		"}\n"
+		"if (r != a) {\n"
+		"ssize_t n = $(fromMemory)(r,a-r);\n"
+		"if (n < 0)\n"
+		"return n;\n"
+		"}\n"
+		"return a-(const uint8_t *)b;\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeMergeFromMemory(Generator &G, Message *m)
+{
+	// Repeated fields that are replaced are cleared in a first pass over
+	// the data, which descends into embedded messages. fromMemory then
+	// appends to repeated fields and parses embedded messages into their
+	// current content. The first pass is run without clearing before, so
+	// that malformed framing leaves the object untouched. Content that
+	// fromMemory rejects leaves the object partially merged.
+	vector<Field *> prep;
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if (!hasMember(f))
+			continue;
+		if (f->isRepeated()) {
+			if (!f->mergeAppends())
+				prep.push_back(f);
+		} else if ((f->getType() & ft_filter) == ft_msg) {
+			prep.push_back(f);
 		}
+	}
+	if (prep.empty()) {
+		G <<	"ssize_t $(prefix)$(msg_name)::$(prepareMerge)(const void *, ssize_t, bool)\n"
+			"{\n"
+			"return 0;\n"
+			"}\n"
+			"\n";
 	} else {
-		for (auto i : fields) {
-			Field *f = i.second;
-			if ((f != 0) && f->isUsed() && !f->isDeprecated() && !f->isObsolete()) {
-				needN = true;
-				break;
+		G <<	"ssize_t $(prefix)$(msg_name)::$(prepareMerge)(const void *b, ssize_t s, bool clear)\n"
+			"{\n"
+			"const uint8_t *a = (const uint8_t *)b;\n"
+			"const uint8_t *e = a + s;\n"
+			"while (a < e) {\n"
+			"varint_t fid;\n"
+			"int fn = read_varint(a,e-a,&fid);\n"
+			"if (fn <= 0)\n"
+			"	$handle_error;\n"
+			"a += fn;\n"
+			"if (a >= e)\n"
+			"	$handle_error;\n"
+			"switch (fid >> 3) {\n";
+		for (Field *f : prep) {
+			G.setField(f);
+			G <<	"case $(field_id):\t// $(fname)\n";
+			if (f->isRepeated()) {
+				G <<	"if (clear)\n"
+					"	$(field_clear)();\n";
+			} else {
+				G <<	"if ((fid & 7) == 2) {\n"
+					"varint_t v;\n"
+					"int n = read_varint(a,e-a,&v);\n"
+					"if ((n <= 0) || (v > (varint_t)(e-a-n)))\n"
+					"	$handle_error;\n";
+				if (f->isLazy())
+					G <<	"if (clear)\n"
+						"	lazy_decode_$(fname)();\n";
+				G <<	"ssize_t r = m_$(fname).$(prepareMerge)(a+n,v,clear);\n"
+					"if (r < 0)\n"
+					"return r;\n"
+					"}\n";
 			}
+			G <<	"break;\n";
+			G.setField(0);
 		}
+		G <<	"default:\n"
+			"break;\n"
+			"}\n";
+		writeSkipField(G);
+		G <<	"}\n"
+			"return 0;\n"
+			"}\n"
+			"\n";
 	}
-	if (needN)
-		G <<	"signed n;\n";
-	for (auto i : fields) {
+	G <<	"ssize_t $(prefix)$(msg_name)::$(mergeFromMemory)(const void *b, ssize_t s)\n"
+		"{\n";
+	if (!prep.empty())
+		G <<	"ssize_t r = $(prepareMerge)(b,s,false);\n"
+			"if (r < 0)\n"
+			"return r;\n"
+			"$(prepareMerge)(b,s,true);\n";
+	G <<	"return $(fromMemory)(b,s);\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeParser(Generator &G, Message *m)
+{
+	// Only embedded messages with regular storage are descended into.
+	// All other length prefixed fields are collected and passed to
+	// fromMemory of the message.
+	vector<Field *> submsgs;
+	for (auto i : m->getFields()) {
 		Field *f = i.second;
-		if (f == 0)
+		if ((f == 0) || !f->isUsed() || f->isObsolete() || f->isDeprecated() || f->isVirtual())
 			continue;
-		if (f->isDeprecated() || f->isObsolete() || !f->isUsed()) {
-			if (WithComments) {
-				G.setField(f);
-				G << "// '$(fname)' is" << f->getUsage() << ". Therefore no data will be written.\n";
-				G.setField(0);
+		uint32_t type = f->getTypeClass();
+		if ((type == ft_cptr) || (((type == ft_string) || (type == ft_bytes)) && (0 == strcmp(f->getTypeName(),"BufView"))))
+			warn("%s.%s references the parsed data, which need not be valid after feeding it to the parser",m->getName().c_str(),f->getName());
+		else if ((type == ft_msg) && (f->getStorage() == mem_regular))
+			submsgs.push_back(f);
+	}
+	G <<	"ssize_t $(prefix)$(msg_name)::$(parser)::parse(void *m, const void *b, ssize_t s)\n"
+		"{\n"
+		"return (($(prefix)$(msg_name) *)m)->$(fromMemory)(b,s);\n"
+		"}\n"
+		"\n";
+	if (submsgs.empty()) {
+		G <<	"void *$(prefix)$(msg_name)::$(parser)::submsg(void *, unsigned, const WireParserType **)\n"
+			"{\n"
+			"return 0;\n"
+			"}\n"
+			"\n";
+	} else {
+		G <<	"void *$(prefix)$(msg_name)::$(parser)::submsg(void *m, unsigned tag, const WireParserType **t)\n"
+			"{\n"
+			"$(prefix)$(msg_name) *o = ($(prefix)$(msg_name) *)m;\n"
+			"switch (tag) {\n";
+		for (Field *f : submsgs) {
+			G.setField(f);
+			G <<	"case $(field_tag):\t// $(fname) id $(field_id), type $typestr\n"
+				"*t = &$(fulltype)::$(parser)::Type;\n";
+			if (f->isRepeated()) {
+				G <<	"o->m_$(fname).emplace_back();\n"
+					"return &o->m_$(fname).back();\n";
+			} else {
+				if (f->isLazy())
+					G << "o->lazy_decode_$(fname)();\n";
+				int vbit = f->getValidBit();
+				if (vbit >= 0)
+					G << "o->" << setValid(vbit,m->getNumValid());
+				G << "return &o->m_$(fname);\n";
 			}
-		} else {
-			writeToMemory(G,f);
+			G.setField(0);
 		}
+		G <<	"default:\n"
+			"return 0;\n"
+			"}\n"
+			"}\n"
+			"\n";
 	}
-	//if (Asserts)
-		//G <<	"assert((a-b) == (signed)$calcSize());\n";
-	const string &Terminator = target->getOption("Terminator");
-	if ((Terminator == "ff") || (Terminator == "0xff")) {
-		if (WithComments)
-			G << "// write terminating ff byte\n";
-		G << "*a++ = 0xff;\n";
-	} else if ((Terminator == "null") || (Terminator == "0x0") || (Terminator == "0")) {
-		if (WithComments)
-			G <<"// write terminating null byte\n";
-		G << "*a++ = 0;\n";
-	}
-	if (Asserts)
-		G << "assert(a <= e);\n";
-	G <<	"return a-b;\n"
-		"}\n"
+	G <<	"const WireParserType $(prefix)$(msg_name)::$(parser)::Type = {\n"
+		"$(prefix)$(msg_name)::$(parser)::parse,\n"
+		"$(prefix)$(msg_name)::$(parser)::submsg,\n"
+		"};\n"
 		"\n";
 }
 
 
-void CppGenerator::writeToJson(Generator &G, Field *f, char fsep)
+static void writeValidateContent(Generator &G, wiretype_t t)
 {
-	// fsepmode: 0 = '{', 1 = ',', 2 = fsep
-	uint8_t quan = f->getQuantifier();
-	uint32_t type = f->getType();
-	const char *writevalue = 0;
-	string av;
-	if (!f->getJsonFunction().empty()) {
-		av	= "json.put('\"');\n"
-			+ f->getJsonFunction()
-			+  "(json,$(field_value));\n"
-			   "json.put('\"');\n";
-		writevalue = av.c_str();
-	} else if (f->isEnum()) {
-		writevalue = 
-			"if (const char *v = $(strfun)($(field_value))) {\n"
-			"json.put('\"');\n"
-			"json << v;\n"
-			"json.put('\"');\n"
-			"} else {\n"
-			"json << $(field_value);\n"
+	// check that a value of wire type t is within bounds, the tag
+	// has already been consumed
+	switch (t) {
+	case wt_varint:
+		G <<	"{\n"
+			"varint_t v;\n"
+			"int n = read_varint(a,e-a,&v);\n"
+			"if (n <= 0)\n"
+			"	return -1;\n"
+			"a += n;\n"
 			"}\n";
-	} else if (type == ft_bool) {
-		writevalue = "json << ($(field_value) ? \"true\" : \"false\");\n";
-	} else if (f->isNumeric()) {
-		if ((type == ft_float) || (type == ft_double)) {
-			writevalue = "to_dblstr(json,$(field_value));\n";
-		} else if ((type == ft_int8) || (type == ft_sint8) || (type == ft_sfixed8)) {
-			if (optmode == optsize)
-				writevalue = "to_decstr(json,(int) $(field_value));\n";
-			else
-				writevalue = "json << (int) $(field_value);\n";
-		} else if ((type == ft_uint8) || (type == ft_fixed8)) {
-			if (optmode == optsize)
-				writevalue = "to_decstr(json,(unsigned) $(field_value));\n";
-			else
-				writevalue = "json << (unsigned) $(field_value);\n";
-		} else {
-			if (optmode == optsize)
-				writevalue = "to_decstr(json,$field_value);\n";
-			else
-				writevalue = "json << $(field_value);\n";
-		}
-	} else if (f->isString()) {
-		switch (f->getType()) {
-		case ft_bytes:
-			writevalue = "json_string(json,$(field_value));\n";
-			break;
-		case ft_string:
-			writevalue = "json_cstr(json,$(field_value).c_str());\n";
-			break;
-		case ft_cptr:
-			writevalue = "json_cstr(json,$(field_value));\n";
-			break;
-		default:
-			abort();
-		}
-	} else if (f->isMessage()) {
-		writevalue = "$(field_value).$(toJSON)(json,indLvl);\n";
-	} else {
-		abort();
-	}
-
-	switch (quan) {
 		break;
-	case q_optional:
-		G <<	"if ($(field_has)()) {\n";
-		if (fsep) {
-			G <<	"$json_indent(json,indLvl,'" << fsep << "',\"$fname\");\n";
-		} else {
-			G <<	"fsep = $json_indent(json,indLvl,fsep,\"$fname\");\n";
-		}
-		G <<	writevalue
-		<<	"}\n";
+	case wt_64bit:
+		G <<	"if ((e-a) < 8)\n"
+			"	return -1;\n"
+			"a += 8;\n";
 		break;
-	case q_required:
-		if (fsep) {
-			G <<	"$json_indent(json,indLvl,'" << fsep << "',\"$fname\");\n";
-		} else {
-			G <<	"fsep = $json_indent(json,indLvl,fsep,\"$fname\");\n";
-		}
-		G <<	writevalue;
+	case wt_32bit:
+		G <<	"if ((e-a) < 4)\n"
+			"	return -1;\n"
+			"a += 4;\n";
 		break;
-	case q_repeated:
-		G.addVariable("index","i");
-		G <<	"if (size_t s = $(field_size)) {\n";
-		if (fsep) {
-			G <<	"$json_indent(json,indLvl,'" << fsep << "');\n";
-		} else {
-			G <<	"fsep = $json_indent(json,indLvl,fsep);\n";
-		}
-		G <<	"indLvl += 2;\n"
-			"json << \"\\\"$(fname)\\\":[\\n\";\n"
-			"size_t i = 0;\n"
-			"for (;;) {\n"
-			"$json_indent(json,indLvl,0);\n"
-			<< writevalue <<
-			"++i;\n"
-			"if (i == s)\n"
-			"break;\n"
-			"json << \",\\n\";\n"
-			"}\n"
-			"indLvl -= 2;\n"
-			"json.put('\\n');\n"
-			"$json_indent(json,indLvl,0);\n"
-			"json.put(']');\n"
-			"}\n";
-		G.clearVariable("index");
+	case wt_16bit:
+		G <<	"if ((e-a) < 2)\n"
+			"	return -1;\n"
+			"a += 2;\n";
+		break;
+	case wt_8bit:
+		G <<	"if (a >= e)\n"
+			"	return -1;\n"
+			"++a;\n";
 		break;
 	default:
-		abort();
+		G <<	"{\n"
+			"varint_t v;\n"
+			"int n = read_varint(a,e-a,&v);\n"
+			"if ((n <= 0) || (v > (varint_t)(e-a-n)))\n"
+			"	return -1;\n"
+			"a += n + v;\n"
+			"}\n";
 	}
 }
 
 
-static string resolve_esc(const string &s)
+static wiretype_t elementWireType(uint32_t type)
 {
-	string r;
-	const char *str = s.c_str();
-	while (char c = *str++) {
-		if (c == '\\') {
-			switch (char e = *str++) {
-			case 't':
-				r += '\t';
-				break;
+	// wire type used by fromMemory for decoding a value of type
+	switch (type) {
+	case ft_msg:
+	case ft_bytes:
+	case ft_string:
+	case ft_cptr:
+		return wt_lenpfx;
+	case ft_bool:
+	case ft_fixed8:
+	case ft_sfixed8:
+		return wt_8bit;
+	case ft_fixed16:
+	case ft_sfixed16:
+		return wt_16bit;
+	case ft_fixed32:
+	case ft_sfixed32:
+	case ft_float:
+		return wt_32bit;
+	case ft_fixed64:
+	case ft_sfixed64:
+	case ft_double:
+		return wt_64bit;
+	default:
+		return wt_varint;
+	}
+}
+
+
+void CppGenerator::writeValidate(Generator &G, Field *f)
+{
+	// same dispatch as writeFromMemory, but only the bounds of the
+	// values are checked
+	G.setField(f);
+	uint32_t type = f->getTypeClass();
+	uint32_t id = f->getId();
+	wiretype_t wt = f->isPacked() ? elementWireType(type) : f->getEncoding();
+	if (!f->isUsed() || f->isObsolete()) {
+		G <<	"case $(field_tag):\t// $(fname) id $(field_id), unused\n";
+		writeValidateContent(G,f->getEncoding());
+		G <<	"break;\n";
+		G.setField(0);
+		return;
+	}
+	if (f->isPacked()) {
+		G.setVariableHex("field_tag",(int64_t)id<<3|2);
+		G <<	"case $(field_tag): {\t// $(fname) id $(field_id), packed $(typestr)[] coding 2\n"
+			"varint_t v;\n"
+			"int n = read_varint(a,e-a,&v);\n"
+			"if ((n <= 0) || (v > (varint_t)(e-a-n)))\n"
+			"	return -1;\n"
+			"a += n;\n";
+		switch (wt) {
+		case wt_varint:
+			G <<	"const uint8_t *ae = a + v;\n"
+				"while (a < ae) {\n"
+				"varint_t x;\n"
+				"int l = read_varint(a,ae-a,&x);\n"
+				"if (l <= 0)\n"
+				"	return -1;\n"
+				"a += l;\n"
+				"}\n";
+			break;
+		case wt_8bit:
+			G <<	"a += v;\n";
+			break;
+		case wt_16bit:
+			G <<	"if (v % 2)\n"
+				"	return -1;\n"
+				"a += v;\n";
+			break;
+		case wt_32bit:
+			G <<	"if (v % 4)\n"
+				"	return -1;\n"
+				"a += v;\n";
+			break;
+		case wt_64bit:
+			G <<	"if (v % 8)\n"
+				"	return -1;\n"
+				"a += v;\n";
+			break;
+		default:
+			abort();
+		}
+		G <<	"} break;\n";
+		// fromMemory also accepts unpacked elements
+		uint32_t enc = f->getElementEncoding();
+		if (enc == wt_lenpfx) {
+			G.setField(0);
+			return;
+		}
+		G.setVariableHex("field_tag",(int64_t)id<<3|enc);
+		wt = (wiretype_t)enc;
+	}
+	bool flex = false;
+	switch (type) {
+	case ft_signed:
+	case ft_sint8:
+	case ft_sint16:
+	case ft_sint32:
+	case ft_sint64:
+		break;
+	default:
+		if (wt == wt_varint) {
+			G.setVariableHex("field_tag",(int64_t)id<<3|wt_varint);
+			flex = target->getFlag("FlexDecoding");
+		}
+	}
+	G <<	"case $(field_tag):\t// $(fname) id $(field_id), type $typestr\n";
+	if (type == ft_msg) {
+		G <<	"{\n"
+			"varint_t v;\n"
+			"int n = read_varint(a,e-a,&v);\n"
+			"if ((n <= 0) || (v > (varint_t)(e-a-n)))\n"
+			"	return -1;\n"
+			"a += n;\n"
+			"if ($(fulltype)::$(validate)(a,v) != (ssize_t)v)\n"
+			"	return -1;\n"
+			"a += v;\n"
+			"}\n";
+	} else if (type == ft_cptr) {
+		// fromMemory only accepts null terminated strings
+		G <<	"{\n"
+			"varint_t v;\n"
+			"int n = read_varint(a,e-a,&v);\n"
+			"if ((n <= 0) || (v == 0) || (v > (varint_t)(e-a-n)))\n"
+			"	return -1;\n"
+			"a += n;\n"
+			"if (a[v-1] != 0)\n"
+			"	return -1;\n"
+			"a += v;\n"
+			"}\n";
+	} else {
+		writeValidateContent(G,wt);
+	}
+	if (f->getQuantifier() == q_required)
+		G << "has_$(fname) = true;\n";
+	G << "break;\n";
+	if (flex) {
+		static const wiretype_t wts[] = { wt_8bit, wt_16bit, wt_32bit, wt_64bit };
+		for (wiretype_t x : wts) {
+			G.setVariableHex("field_tag",(int64_t)id<<3|x);
+			G << "case $(field_tag):\t// $(fname) id $(field_id), type $typestr, flexible coding\n";
+			writeValidateContent(G,x);
+			if (f->getQuantifier() == q_required)
+				G << "has_$(fname) = true;\n";
+			G << "break;\n";
+		}
+	}
+	G.setField(0);
+}
+
+
+void CppGenerator::writeValidate(Generator &G, Message *m)
+{
+	G <<	"ssize_t $(prefix)$(msg_name)::$(validate)(const void *b, ssize_t s)\n"
+		"{\n"
+		"const uint8_t *a = (const uint8_t *)b;\n"
+		"const uint8_t *e = a + s;\n";
+	vector<Field *> required;
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f != 0) && f->isUsed() && !f->isObsolete() && (f->getQuantifier() == q_required))
+			required.push_back(f);
+	}
+	for (Field *f : required)
+		G << "bool has_" << f->getName() << " = false;\n";
+	G <<	"while (a < e) {\n";
+	writeTerminatorCheck(G);
+	G <<	"varint_t fid;\n"
+		"int fn = read_varint(a,e-a,&fid);\n"
+		"if (fn <= 0)\n"
+		"	return -1;\n"
+		"a += fn;\n"
+		"switch (fid) {\n";
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if (f == 0)
+			continue;
+		writeValidate(G,f);
+	}
+	G <<	"default:\n"
+		"	return -1;\n"
+		"}\n"
+		"}\n";
+	for (Field *f : required)
+		G <<	"if (!has_" << f->getName() << ")\n"
+			"	return -1;\n";
+	G <<	"return a-(const uint8_t *)b;\n"
+		"}\n"
+		"\n";
+}
+
+
+static bool hasFixedLayout(Message *m)
+{
+	// all fields are required and of fixed width, so that tags and
+	// values are located at constant offsets on the wire
+	if (!m->hasFixedSize())
+		return false;
+	bool any = false;
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed())
+			continue;
+		if (f->isDeprecated() || f->isObsolete() || f->isVirtual())
+			return false;
+		switch (f->getType()) {
+		case ft_bool:
+		case ft_fixed8:
+		case ft_sfixed8:
+		case ft_fixed16:
+		case ft_sfixed16:
+		case ft_fixed32:
+		case ft_sfixed32:
+		case ft_float:
+		case ft_fixed64:
+		case ft_sfixed64:
+		case ft_double:
+			break;
+		default:
+			return false;
+		}
+		any = true;
+	}
+	return any;
+}
+
+
+int CppGenerator::terminatorByte()
+{
+	// byte that terminates the serialized message, -1 for none
+	const string &Terminator = target->getOption("Terminator");
+	if ((Terminator == "ff") || (Terminator == "0xff") || (Terminator == "FF") || (Terminator == "0xFF"))
+		return 0xff;
+	if ((Terminator == "null") || (Terminator == "0x0") || (Terminator == "0"))
+		return 0;
+	return -1;
+}
+
+
+void CppGenerator::writeTerminator(Generator &G, const char *check, const char *store)
+{
+	// store writes $(terminator), after check has been tested for
+	// lack of space
+	int term = terminatorByte();
+	if (term < 0)
+		return;
+	if (WithComments)
+		G << (term ? "// write terminating ff byte\n" : "// write terminating null byte\n");
+	if (check)
+		G <<	"if (" << check << ")\n"
+			"	$handle_error;\n";
+	string st = store;
+	size_t p = st.find("$(terminator)");
+	assert(p != string::npos);
+	st.replace(p,13,term ? "0xff" : "0");
+	G << st;
+}
+
+
+void CppGenerator::writeTerminatorCheck(Generator &G)
+{
+	// decoding loops stop in front of the terminator
+	int term = terminatorByte();
+	if (term < 0)
+		return;
+	G <<	(term ? "if (*a == 0xff)\t// 0xff terminator\n" : "if (*a == 0)\t// null terminator\n")
+		<< "break;\n";
+}
+
+
+bool CppGenerator::useFixedLayout(Message *m)
+{
+	if ((optmode != optspeed) || (Endian != little_endian))
+		return false;
+	if (terminatorByte() >= 0)
+		return false;
+	return hasFixedLayout(m);
+}
+
+
+void CppGenerator::writeToMemoryFixed(Generator &G, Message *m)
+{
+	// copy the wire image with constant tags and fill in the values
+	string image, values;
+	unsigned off = 0;
+	char buf[64];
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed())
+			continue;
+		G.setField(f);
+		unsigned xid = (f->getId() << 3) | f->getEncoding();
+		while (xid & (~0x7f)) {
+			sprintf(buf,"0x%x,",(xid&0x7f)|0x80);
+			image += buf;
+			xid >>= 7;
+			++off;
+		}
+		sprintf(buf,"0x%x,",xid);
+		image += buf;
+		++off;
+		unsigned n = f->getFixedSize(false);
+		for (unsigned x = 0; x < n; ++x)
+			image += "0,";
+		if (n == 1)
+			sprintf(buf,"b[%u] = ",off);
+		else
+			sprintf(buf,"memcpy(b+%u,&",off);
+		string v = G.getVariable("field_value");
+		G.setField(0);
+		values += buf;
+		values += v;
+		if (n == 1)
+			values += ";\n";
+		else
+			values += ",sizeof(" + v + "));\n";
+		off += n;
+	}
+	image.resize(image.size()-1);
+	if (WithComments)
+		G <<	"// fixed layout: constant tags, values at constant offsets\n";
+	G <<	"static const uint8_t image[] = { " << image << " };\n"
+		"if (s < " << off << ")\n"
+		"	$handle_error;\n"
+		"memcpy(b,image,sizeof(image));\n";
+	G << values;
+	G <<	"return " << off << ";\n";
+}
+
+
+void CppGenerator::writeFromMemoryFixed(Generator &G, Message *m)
+{
+	// verify the tags and load the values from constant offsets
+	string cond, values;
+	unsigned off = 0;
+	char buf[64];
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed())
+			continue;
+		G.setField(f);
+		unsigned xid = (f->getId() << 3) | f->getEncoding();
+		while (xid & (~0x7f)) {
+			sprintf(buf," && (a[%u] == 0x%x)",off,(xid&0x7f)|0x80);
+			cond += buf;
+			xid >>= 7;
+			++off;
+		}
+		sprintf(buf," && (a[%u] == 0x%x)",off,xid);
+		cond += buf;
+		++off;
+		unsigned n = f->getFixedSize(false);
+		string v = G.getVariable("field_value");
+		G.setField(0);
+		if (f->getType() == ft_bool) {
+			// only a single byte bool is loaded here, others take the generic decoder
+			sprintf(buf," && (a[%u] < 0x80)",off);
+			cond += buf;
+		}
+		if (n == 1) {
+			sprintf(buf," = a[%u];\n",off);
+			values += v + buf;
+		} else {
+			sprintf(buf,",a+%u,sizeof(",off);
+			values += "memcpy(&" + v + buf + v + "));\n";
+		}
+		off += n;
+	}
+	if (WithComments)
+		G <<	"// fixed layout: all fields in order with constant tags\n";
+	G <<	"if ((s == " << off << ")" << cond << ") {\n";
+	G << values;
+	G <<	"return " << off << ";\n"
+		"}\n";
+}
+
+
+static int64_t maxValueSize(Field *f, wiretype_t enc, unsigned padlen, vector<Message *> &stack);
+
+
+static int64_t maxUncheckedSize(Message *m, unsigned padlen, vector<Message *> &stack)
+{
+	// upper bound of the size of m on the wire, or -1 if unbounded
+	// message types already on the stack are recursive, i.e. unbounded
+	if (std::find(stack.begin(),stack.end(),m) != stack.end())
+		return -1;
+	stack.push_back(m);
+	int64_t r = 0;
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || f->isDeprecated() || f->isObsolete() || !f->isUsed())
+			continue;
+		unsigned n = 1;
+		if (f->isRepeated()) {
+			// the size of virtual arrays is not limited by arraysize
+			n = f->getArraySize();
+			if ((n == 0) || f->isVirtual()) {
+				r = -1;
+				break;
+			}
+		}
+		uint32_t type = f->getType();
+		wiretype_t enc = f->getEncoding();
+		if ((type & ft_filter) == ft_msg)
+			enc = wt_msg;
+		else if (f->isPacked())
+			enc = elementWireType(type);
+		int64_t vs = maxValueSize(f,enc,padlen,stack);
+		if (vs == -1) {
+			r = -1;
+			break;
+		}
+		if (f->isPacked())
+			r += f->getTagSize() + wiresize_u64(vs*n) + vs*n;
+		else
+			r += (f->getTagSize() + vs) * n;
+	}
+	stack.pop_back();
+	return r;
+}
+
+
+static int64_t maxValueSize(Field *f, wiretype_t enc, unsigned padlen, vector<Message *> &stack)
+{
+	uint32_t type = f->getType();
+	switch (enc) {
+	case wt_8bit:
+		return 1;
+	case wt_16bit:
+		return 2;
+	case wt_32bit:
+		return 4;
+	case wt_64bit:
+		return 8;
+	case wt_varint:
+		switch (type) {
+		case ft_bool:
+			return 1;
+		case ft_uint8:
+		case ft_sint8:
+			return 2;
+		case ft_uint16:
+		case ft_sint16:
+			return 3;
+		case ft_uint32:
+		case ft_sint32:
+			return 5;
+		default:
+			// negative int and enum values are sign extended to 64 bit
+			return 10;
+		}
+	case wt_msg:
+		{
+			// lazy fields may hold arbitrary data that was not decoded
+			if (f->isLazy())
+				return -1;
+			int64_t ms = maxUncheckedSize(Message::id2msg(type),padlen,stack);
+			if (ms == -1)
+				return -1;
+			return ms + (padlen ? padlen : wiresize_u64(ms));
+		}
+	default:
+		return -1;
+	}
+}
+
+
+bool CppGenerator::toMemoryUsesN(Message *m)
+{
+	// whether the code of writeToMemory(Field) needs variable n
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || (!f->isUsed()) || f->isDeprecated() || f->isObsolete())
+			continue;
+		if (optmode == optspeed) {
+			if (!f->hasFixedSize() || (f->isRepeated() && f->isPacked()) || (f->getType() == ft_msg))
+				return true;
+		} else if (optmode == optsize) {
+			if ((f->getTagSize() > 2) || !f->hasFixedSize() || (f->isRepeated() && f->isPacked()) || (f->getType() == ft_msg))
+				return true;
+		} else {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void CppGenerator::writeToMemory(Generator &G, Message *m)
+{
+	G <<	"ssize_t $(prefix)$(msg_name)::$toMemory(uint8_t *b, ssize_t s) const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$toMemory(\" << (void*)b << \", \" << s << \")\\n\";\n";
+	if (Asserts)
+		G << "assert(s >= 0);\n";
+	if (useFixedLayout(m)) {
+		writeToMemoryFixed(G,m);
+		G <<	"}\n"
+			"\n";
+		return;
+	}
+	if (G.hasValue("toMemoryUnchecked")) {
+		vector<Message *> stack;
+		int64_t ms = maxUncheckedSize(m,PaddedMsgSize ? VarIntBits/7+1 : 0,stack);
+		if (ms != -1) {
+			if (terminatorByte() >= 0)
+				++ms;
+			if (WithComments)
+				G <<	"// any content fits into " << ms << " bytes\n";
+			G <<	"if (s >= " << ms << ")\n"
+				"	return $(toMemoryUnchecked)(b);\n";
+		}
+	}
+	G <<	"uint8_t *a = b, *e = b + s;\n";
+	if (toMemoryUsesN(m))
+		G <<	"signed n;\n";
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if (f == 0)
+			continue;
+		if (f->isDeprecated() || f->isObsolete() || !f->isUsed()) {
+			if (WithComments) {
+				G.setField(f);
+				G << "// '$(fname)' is" << f->getUsage() << ". Therefore no data will be written.\n";
+				G.setField(0);
+			}
+		} else {
+			writeToMemory(G,f);
+		}
+	}
+	//if (Asserts)
+		//G <<	"assert((a-b) == (signed)$calcSize());\n";
+	writeTerminator(G,0,"*a++ = $(terminator);\n");
+	if (Asserts)
+		G << "assert(a <= e);\n";
+	G <<	"return a-b;\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeToMemoryDelta(Generator &G, Message *m)
+{
+	// Fields are written as by toMemory, if their dirty bit is set.
+	// Message fields are always written completely. Modifications of
+	// virtual fields cannot be tracked, so they are always written.
+	G <<	"ssize_t $(prefix)$(msg_name)::$(toMemoryDelta)(uint8_t *b, ssize_t s) const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toMemoryDelta)(\" << (void*)b << \", \" << s << \")\\n\";\n";
+	if (Asserts)
+		G << "assert(s >= 0);\n";
+	G <<	"uint8_t *a = b, *e = b + s;\n";
+	if (toMemoryUsesN(m))
+		G <<	"signed n;\n";
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed() || f->isDeprecated() || f->isObsolete())
+			continue;
+		if (f->isVirtual()) {
+			writeToMemory(G,f);
+			continue;
+		}
+		unsigned d = getDirtyBit(f);
+		char cond[64];
+		sprintf(cond,"if (p_dirtybits[%u] & 0x%x) {\n",d/8,1<<(d&7));
+		G <<	cond;
+		writeToMemory(G,f);
+		G <<	"}\n";
+	}
+	writeTerminator(G,"a >= e","*a++ = $(terminator);\n");
+	if (Asserts)
+		G << "assert(a <= e);\n";
+	G <<	"return a-b;\n"
+		"}\n"
+		"\n"
+		"void $(prefix)$(msg_name)::$(markClean)()\n"
+		"{\n";
+	if (numDirtyBits(m) > 0)
+		G <<	"memset(p_dirtybits,0,sizeof(p_dirtybits));\n";
+	G <<	"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeTagToMemoryReverse(Generator &G, Field *f)
+{
+	unsigned xid = (f->getId() << 3) | f->getEncoding();
+	if (f->isPacked())
+		xid = (f->getId() << 3) | 2;
+	G << "// '$(fname)': id=$(field_id), encoding=$(field_enc), tag=$(field_tag)\n";
+	unsigned ts = wiresize_u64(xid);
+	if (ts == 1)
+		G <<	"if (a == b)\n"
+			"	$handle_error;\n";
+	else
+		G <<	"if (" << ts << " > (a-b))\n"
+			"	$handle_error;\n";
+	// bytes of the tag from the last to the first
+	uint8_t tag[8];
+	for (unsigned i = 0; i != ts; ++i) {
+		tag[i] = (xid & 0x7f) | (i+1 == ts ? 0 : 0x80);
+		xid >>= 7;
+	}
+	while (ts) {
+		char buf[8];
+		sprintf(buf,"%x",tag[--ts]);
+		G << "*--a = 0x" << buf << ";\n";
+	}
+}
+
+
+void CppGenerator::writeValueToMemoryReverse(Generator &G, Field *f)
+{
+	uint32_t type = f->getType();
+	uint32_t encoding = f->getEncoding();
+	if ((type & ft_filter) == ft_msg)
+		encoding = wt_msg;
+	else if (f->isPacked())
+		encoding = elementWireType(type);
+	switch (encoding) {
+	case wt_varint:
+		if ((type == ft_sint8) || (type == ft_sint16) || (type == ft_sint32) || (type == ft_sint64))
+			G <<	"a = rwrite_varint(b,a,sint_varint($(field_value)));\n";
+		else if ((VarIntBits < 64) && ((type == ft_int8) || (type == ft_int16) || (type == ft_int32)))
+			G <<	"a = rwrite_xvarint(b,a,$(field_value));\n";
+		else
+			G <<	"a = rwrite_varint(b,a,$(field_value));\n";
+		G <<	"if (a == 0)\n"
+			"	$handle_error;\n";
+		break;
+	case wt_8bit:
+		G <<	"if (a == b)\n"
+			"	$handle_error;\n"
+			"*--a = $(field_value);\n";
+		break;
+	case wt_16bit:
+		G <<	"if ((a-b) < 2)\n"
+			"	$handle_error;\n"
+			"a -= 2;\n"
+			"write_u16(a,$(field_value));\n";
+		break;
+	case wt_32bit:
+		G <<	"if ((a-b) < 4)\n"
+			"	$handle_error;\n"
+			"a -= 4;\n";
+		if (type == ft_float)
+			G <<	"write_u32(a,mangle_float($(field_value)));\n";
+		else
+			G <<	"write_u32(a,(uint32_t)$(field_value));\n";
+		break;
+	case wt_64bit:
+		G <<	"if ((a-b) < 8)\n"
+			"	$handle_error;\n"
+			"a -= 8;\n";
+		if (type == ft_double)
+			G <<	"write_u64(a,mangle_double($(field_value)));\n";
+		else
+			G <<	"write_u64(a,(uint64_t)$(field_value));\n";
+		break;
+	case wt_msg:
+		if (f->isLazy()) {
+			// emit data that has not been decoded verbatim
+			G <<	"if (lazy_$(fname)) {\n"
+				"if ((size_t)(a-b) < lazysize_$(fname))\n"
+				"	$handle_error;\n"
+				"a -= lazysize_$(fname);\n"
+				"memcpy(a,lazy_$(fname),lazysize_$(fname));\n"
+				"a = rwrite_varint(b,a,lazysize_$(fname));\n"
+				"} else {\n";
+		}
+		// the embedded message ends at a and starts at b+n
+		G <<	"ssize_t $(fname)_n = $(field_value).$(toMemoryReverse)(b,a-b);\n"
+			"if ($(fname)_n < 0)\n"
+			"	$handle_error;\n"
+			"a = rwrite_varint(b,b+$(fname)_n,(a-b)-$(fname)_n);\n";
+		if (f->isLazy())
+			G << "}\n";
+		G <<	"if (a == 0)\n"
+			"	$handle_error;\n";
+		break;
+	case wt_lenpfx:
+		if (type == ft_cptr) {
+			// null pointers are transmitted as empty string of length 1
+			G <<	"size_t $(fname)_s = $(field_value) ? strlen($(field_value)) + 1 : 1;\n"
+				"if ((size_t)(a-b) < $(fname)_s)\n"
+				"	$handle_error;\n"
+				"a -= $(fname)_s;\n"
+				"if ($(field_value))\n"
+				"	memcpy(a,$(field_value),$(fname)_s);\n"
+				"else\n"
+				"	*a = 0;\n";
+		} else {
+			G <<	"size_t $(fname)_s = $(field_value).size();\n"
+				"if ((size_t)(a-b) < $(fname)_s)\n"
+				"	$handle_error;\n"
+				"a -= $(fname)_s;\n"
+				"memcpy(a,$(field_value).data(),$(fname)_s);\n";
+		}
+		G <<	"a = rwrite_varint(b,a,$(fname)_s);\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n";
+		break;
+	default:
+		abort();
+	}
+}
+
+
+void CppGenerator::writeToMemoryReverse(Generator &G, Field *f)
+{
+	G.setField(f);
+	uint32_t type = f->getType();
+	switch (f->getQuantifier()) {
+	case q_optional:
+		if ((optmode == optreview) || (mem_virtual == f->getStorage())) {
+			G <<	"if ($(field_has)()) {\n";
+		} else {
+			if (WithComments)
+				G <<	"// has $fname?\n";
+			G <<	"if (";
+			writeGetValid(G,f);
+			G <<	") {\n";
+		}
+		writeValueToMemoryReverse(G,f);
+		writeTagToMemoryReverse(G,f);
+		G <<	"}\n";
+		break;
+	case q_required:
+		writeValueToMemoryReverse(G,f);
+		writeTagToMemoryReverse(G,f);
+		break;
+	case q_repeated:
+		G.addVariable("index","x");
+		if (f->isPacked() && f->hasSimpleType()) {
+			// packed encoding: elements, length, tag
+			G <<	"if (size_t $(fname)_ne = $(field_size)) {\n";
+			G.setVariableHex("field_tag",f->getId()<<3|2);
+			G <<	"uint8_t *$(fname)_e = a;\n";
+			if (!f->isVirtual() && (((type == ft_bool) || (type == ft_fixed8) ||  (type == ft_sfixed8))
+					|| ((Endian == little_endian) && f->hasFixedSize()))) {
+				G <<	"size_t $(fname)_ws = $(fname)_ne * sizeof($typestr);\n"
+					"if ((size_t)(a-b) < $(fname)_ws)\n"
+					"	$handle_error;\n"
+					"a -= $(fname)_ws;\n"
+					"memcpy(a,$(field_values),$(fname)_ws);\n";
+			} else {
+				G <<	"for (size_t x = $(fname)_ne; x != 0;) {\n"
+					"--x;\n";
+				writeValueToMemoryReverse(G,f);
+				G <<	"}\n";
+			}
+			G <<	"a = rwrite_varint(b,a,$(fname)_e-a);\n"
+				"if (a == 0)\n"
+				"	$handle_error;\n";
+		} else {
+			// elements are written from the last to the first
+			G <<	"for (size_t x = $(field_size); x != 0;) {\n"
+				"--x;\n";
+			writeValueToMemoryReverse(G,f);
+		}
+		writeTagToMemoryReverse(G,f);
+		G <<	"}\n";
+		G.clearVariable("index");
+		break;
+	default:
+		abort();
+	}
+	G.setField(0);
+}
+
+
+void CppGenerator::writeToMemoryReverse(Generator &G, Message *m)
+{
+	G <<	"ssize_t $(prefix)$(msg_name)::$(toMemoryReverse)(uint8_t *b, ssize_t s) const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toMemoryReverse)(\" << (void*)b << \", \" << s << \")\\n\";\n";
+	if (Asserts)
+		G << "assert(s >= 0);\n";
+	G <<	"uint8_t *a = b + s;\n";
+	writeTerminator(G,"a == b","*--a = $(terminator);\n");
+	const map<unsigned,Field *> &fields = m->getFields();
+	for (auto i = fields.rbegin(), e = fields.rend(); i != e; ++i) {
+		Field *f = i->second;
+		if ((f == 0) || f->isDeprecated() || f->isObsolete() || !f->isUsed())
+			continue;
+		writeToMemoryReverse(G,f);
+	}
+	G <<	"return a-b;\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeTagToMemoryUnchecked(Generator &G, Field *f)
+{
+	unsigned xid = (f->getId() << 3) | f->getEncoding();
+	if (f->isPacked())
+		xid = (f->getId() << 3) | 2;
+	G << "// '$(fname)': id=$(field_id), encoding=$(field_enc), tag=$(field_tag)\n";
+	char buf[8];
+	while (xid & (~0x7f)) {
+		sprintf(buf,"%x",(xid&0x7f)|0x80);
+		G << "*a++ = 0x" << buf << ";\n";
+		xid >>= 7;
+	}
+	sprintf(buf,"%x",xid);
+	G << "*a++ = 0x" << buf << ";\n";
+}
+
+
+void CppGenerator::writeValueToMemoryUnchecked(Generator &G, Field *f)
+{
+	// scalar values only, length prefixed data is written by writeValueToBlock
+	uint32_t type = f->getType();
+	uint32_t encoding = f->isPacked() ? elementWireType(type) : f->getEncoding();
+	switch (encoding) {
+	case wt_varint:
+		if ((type == ft_sint8) || (type == ft_sint16) || (type == ft_sint32) || (type == ft_sint64))
+			G <<	"a += uwrite_varint(a,sint_varint($(field_value)));\n";
+		else if ((VarIntBits < 64) && ((type == ft_int8) || (type == ft_int16) || (type == ft_int32)))
+			G <<	"a += uwrite_xvarint(a,$(field_value));\n";
+		else
+			G <<	"a += uwrite_varint(a,$(field_value));\n";
+		break;
+	case wt_8bit:
+		G <<	"*a++ = $(field_value);\n";
+		break;
+	case wt_16bit:
+		G <<	"write_u16(a,$(field_value));\n"
+			"a += 2;\n";
+		break;
+	case wt_32bit:
+		if (type == ft_float)
+			G <<	"write_u32(a,mangle_float($(field_value)));\n";
+		else
+			G <<	"write_u32(a,(uint32_t)$(field_value));\n";
+		G <<	"a += 4;\n";
+		break;
+	case wt_64bit:
+		if (type == ft_double)
+			G <<	"write_u64(a,mangle_double($(field_value)));\n";
+		else
+			G <<	"write_u64(a,(uint64_t)$(field_value));\n";
+		G <<	"a += 8;\n";
+		break;
+	default:
+		abort();
+	}
+}
+
+
+void CppGenerator::writeBlockReserve(Generator &G, blksink_t s, unsigned n)
+{
+	switch (s) {
+	case blk_memory:
+		// the caller provides a buffer of sufficient size
+		break;
+	case blk_wire:
+		// flush the staging buffer if fewer than n bytes are left
+		G <<	"if (a+" << n << " > b+sizeof(b)) {\n"
+			"$wirewrite(b,a-b);\n"
+			"a = b;\n"
+			"}\n";
+		break;
+	case blk_iovec:
+		G <<	"a = v.reserve(" << n << ");\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n";
+		break;
+	default:
+		abort();
+	}
+}
+
+
+void CppGenerator::writeBlockCommit(Generator &G, blksink_t s)
+{
+	if (s == blk_iovec)
+		G <<	"v.commit(a);\n";
+}
+
+
+void CppGenerator::writeBlockData(Generator &G, blksink_t s, const char *data, const char *size, bool mayBeEmpty)
+{
+	// pass on data that is already in wire format
+	string d = data, n = size;
+	switch (s) {
+	case blk_memory:
+		G <<	"memcpy(a," + d + "," + n + ");\n"
+			"a += " + n + ";\n";
+		break;
+	case blk_wire:
+		if (mayBeEmpty)
+			G <<	"if (" + n + ") {\n";
+		writeWireFlush(G);
+		G <<	"$wirewrite((const uint8_t *)" + d + "," + n + ");\n";
+		if (mayBeEmpty)
+			G <<	"}\n";
+		break;
+	case blk_iovec:
+		G <<	"v.commit(a);\n"
+			"if (!v.add(" + d + "," + n + "))\n"
+			"	$handle_error;\n";
+		break;
+	default:
+		abort();
+	}
+}
+
+
+void CppGenerator::writeBlockMsgSize(Generator &G, const char *size)
+{
+	string s;
+	if (PaddedMsgSize) {
+		s =	"place_varint(a,";
+		s +=	size;
+		s +=	");\n"
+			"a += sizeof(varint_t)*8/7+1;\n";
+	} else {
+		s =	"a += uwrite_varint(a,";
+		s +=	size;
+		s +=	");\n";
+	}
+	G << s;
+}
+
+
+void CppGenerator::writeValueToBlock(Generator &G, blksink_t s, Field *f)
+{
+	uint32_t type = f->getType();
+	if (f->isLazy()) {
+		// emit data that has not been decoded verbatim
+		G <<	"if (lazy_$(fname)) {\n";
+		writeBlockMsgSize(G,"lazysize_$(fname)");
+		writeBlockData(G,s,"lazy_$(fname)","lazysize_$(fname)",true);
+		G <<	"} else {\n";
+	}
+	if (((type & ft_filter) == ft_msg) && (s == blk_memory) && PaddedMsgSize) {
+		// the size is placed after serializing the message
+		G <<	"size_t $(fname)_n = $(field_value).$(toMemoryUnchecked)(a+(sizeof(varint_t)*8/7+1));\n"
+			"place_varint(a,$(fname)_n);\n"
+			"a += sizeof(varint_t)*8/7+1+$(fname)_n;\n";
+	} else if (((type & ft_filter) == ft_msg) && CachedSize && !f->isVirtual()) {
+		// a stale cached size must not yield a corrupt length prefix
+		G <<	"ssize_t $(fname)_ws = $(field_value).cachedSize();\n";
+		writeBlockMsgSize(G,"$(fname)_ws");
+		switch (s) {
+		case blk_memory:
+			G <<	"ssize_t $(fname)_n = $(field_value).$(toMemoryUnchecked)(a);\n"
+				"if ($(fname)_n != $(fname)_ws)\n"
+				"	$handle_error;\n"
+				"a += $(fname)_n;\n";
+			break;
+		case blk_wire:
+			// toWire cannot report a stale size
+			writeWireFlush(G);
+			G <<	"$(field_value).$(toWire)();\n";
+			break;
+		case blk_iovec:
+			G <<	"v.commit(a);\n"
+				"if ($(field_value).$(toIovec)(v) != $(fname)_ws)\n"
+				"	$handle_error;\n";
+			break;
+		default:
+			abort();
+		}
+	} else if ((type & ft_filter) == ft_msg) {
+		writeBlockMsgSize(G,"$(field_value).$calcSize()");
+		switch (s) {
+		case blk_memory:
+			G <<	"a += $(field_value).$(toMemoryUnchecked)(a);\n";
+			break;
+		case blk_wire:
+			writeWireFlush(G);
+			G <<	"$(field_value).$(toWire)();\n";
+			break;
+		case blk_iovec:
+			G <<	"v.commit(a);\n"
+				"if ($(field_value).$(toIovec)(v) < 0)\n"
+				"	$handle_error;\n";
+			break;
+		default:
+			abort();
+		}
+	} else if (type == ft_cptr) {
+		G <<	"if ($(field_value)) {\n"
+			"size_t $(fname)_s = strlen($(field_value)) + 1;\n"
+			"a += uwrite_varint(a,$(fname)_s);\n";
+		writeBlockData(G,s,"$(field_value)","$(fname)_s");
+		G <<	"} else {\n"
+			"// transmit empty string of lenght 1\n"
+			"*a++ = 1;\n"
+			"*a++ = 0;\n";
+		writeBlockCommit(G,s);
+		G <<	"}\n";
+	} else if (f->getEncoding() == wt_lenpfx) {
+		G <<	"size_t $(fname)_s = $(field_value).size();\n"
+			"a += uwrite_varint(a,$(fname)_s);\n";
+		writeBlockData(G,s,"$(field_value).data()","$(fname)_s",true);
+	} else {
+		writeValueToMemoryUnchecked(G,f);
+		writeBlockCommit(G,s);
+	}
+	if (f->isLazy())
+		G << "}\n";
+}
+
+
+void CppGenerator::writeToBlock(Generator &G, blksink_t s, Field *f)
+{
+	if (f->isDeprecated() || f->isObsolete()) {
+		if (WithComments)
+			G << "// '" << f->getName() << "' is deprecated. Therefore no data will be written.\n";
+		return;
+	}
+	G.setField(f);
+	uint32_t type = f->getType();
+	unsigned ts = f->getTagSize();
+	// length prefixed values reserve space for tag and length only
+	unsigned vs = 10;
+	if ((s != blk_memory) && ((type & ft_filter) != ft_msg) && (f->getEncoding() != wt_lenpfx) && !f->isPacked()) {
+		vector<Message *> stack;
+		vs = maxValueSize(f,f->getEncoding(),0,stack);
+	}
+	switch (f->getQuantifier()) {
+	case q_optional:
+		if ((optmode == optreview) || f->isVirtual()) {
+			G <<	"if ($(field_has)()) {\n";
+		} else {
+			if (WithComments)
+				G <<	"// has $fname?\n";
+			G <<	"if (";
+			writeGetValid(G,f);
+			G <<	") {\n";
+		}
+		writeBlockReserve(G,s,ts+vs);
+		writeTagToMemoryUnchecked(G,f);
+		writeValueToBlock(G,s,f);
+		G <<	"}\n";
+		break;
+	case q_required:
+		writeBlockReserve(G,s,ts+vs);
+		writeTagToMemoryUnchecked(G,f);
+		writeValueToBlock(G,s,f);
+		break;
+	case q_repeated:
+		G.addVariable("index","x");
+		if (f->isPacked() && f->hasSimpleType()) {
+			// packed encoding: tag, length, elements
+			G <<	"if (size_t $(fname)_ne = $(field_size)) {\n";
+			G.setVariableHex("field_tag",f->getId()<<3|2);
+			writeBlockReserve(G,s,ts+10);
+			writeTagToMemoryUnchecked(G,f);
+			wiretype_t et = elementWireType(type);
+			if (et != wt_varint) {
+				G <<	"size_t $(fname)_ws = $(fname)_ne * sizeof($typestr);\n"
+					"a += uwrite_varint(a,$(fname)_ws);\n";
+			} else {
+				G <<	"size_t $(fname)_ws = 0;\n"
+					"for (size_t x = 0; x != $(fname)_ne; ++x)\n";
+				if ((type == ft_sint8) || (type == ft_sint16) || (type == ft_sint32) || (type == ft_sint64))
+					G <<	"	$(fname)_ws += $(wiresize_s)($(field_value));\n";
+				else if ((VarIntBits < 64) && ((type == ft_int8) || (type == ft_int16) || (type == ft_int32)))
+					G <<	"	$(fname)_ws += $(wiresize_x)($(field_value));\n";
+				else
+					G <<	"	$(fname)_ws += $(wiresize_u)($(field_value));\n";
+				G <<	"a += uwrite_varint(a,$(fname)_ws);\n";
+			}
+			if ((et != wt_varint) && !f->isVirtual() && (((type == ft_bool) || (type == ft_fixed8) ||  (type == ft_sfixed8))
+					|| (Endian == little_endian))) {
+				// elements are passed on as they are stored
+				writeBlockData(G,s,"$(field_values)","$(fname)_ws");
+			} else {
+				vector<Message *> stack;
+				writeBlockCommit(G,s);
+				G <<	"for (size_t x = 0; x != $(fname)_ne; ++x) {\n";
+				writeBlockReserve(G,s,maxValueSize(f,et,0,stack));
+				writeValueToMemoryUnchecked(G,f);
+				writeBlockCommit(G,s);
+				G <<	"}\n";
+			}
+		} else {
+			G <<	"for (size_t x = 0, x_e = $(field_size); x != x_e; ++x) {\n";
+			writeBlockReserve(G,s,ts+vs);
+			writeTagToMemoryUnchecked(G,f);
+			writeValueToBlock(G,s,f);
+		}
+		G <<	"}\n";
+		G.clearVariable("index");
+		break;
+	default:
+		abort();
+	}
+	G.setField(0);
+}
+
+
+void CppGenerator::writeBlockTerminator(Generator &G, blksink_t s)
+{
+	if (terminatorByte() < 0)
+		return;
+	writeBlockReserve(G,s,1);
+	writeTerminator(G,0,"*a++ = $(terminator);\n");
+	writeBlockCommit(G,s);
+}
+
+
+void CppGenerator::writeToMemoryUnchecked(Generator &G, Message *m)
+{
+	G <<	"ssize_t $(prefix)$(msg_name)::$(toMemoryUnchecked)(uint8_t *b) const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toMemoryUnchecked)(\" << (void*)b << \")\\n\";\n";
+	G <<	"uint8_t *a = b;\n";
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || f->isDeprecated() || f->isObsolete() || !f->isUsed())
+			continue;
+		writeToBlock(G,blk_memory,f);
+	}
+	writeBlockTerminator(G,blk_memory);
+	G <<	"return a-b;\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeToJson(Generator &G, Field *f, char fsep)
+{
+	// fsepmode: 0 = '{', 1 = ',', 2 = fsep
+	uint8_t quan = f->getQuantifier();
+	uint32_t type = f->getType();
+	const char *writevalue = 0;
+	string av;
+	if (!f->getJsonFunction().empty()) {
+		av	= "json.put('\"');\n"
+			+ f->getJsonFunction()
+			+  "(json,$(field_value));\n"
+			   "json.put('\"');\n";
+		writevalue = av.c_str();
+	} else if (f->isEnum()) {
+		writevalue = 
+			"if (const char *v = $(strfun)($(field_value))) {\n"
+			"json.put('\"');\n"
+			"json << v;\n"
+			"json.put('\"');\n"
+			"} else {\n"
+			"json << $(field_value);\n"
+			"}\n";
+	} else if (type == ft_bool) {
+		writevalue = "json << ($(field_value) ? \"true\" : \"false\");\n";
+	} else if (f->isNumeric()) {
+		if ((type == ft_float) || (type == ft_double)) {
+			writevalue = "to_dblstr(json,$(field_value));\n";
+		} else if ((type == ft_int8) || (type == ft_sint8) || (type == ft_sfixed8)) {
+			if (optmode == optreview)
+				writevalue = "json << (int) $(field_value);\n";
+			else
+				writevalue = "to_decstr(json,(int) $(field_value));\n";
+		} else if ((type == ft_uint8) || (type == ft_fixed8)) {
+			if (optmode == optreview)
+				writevalue = "json << (unsigned) $(field_value);\n";
+			else
+				writevalue = "to_decstr(json,(unsigned) $(field_value));\n";
+		} else {
+			if (optmode == optreview)
+				writevalue = "json << $(field_value);\n";
+			else
+				writevalue = "to_decstr(json,$(field_value));\n";
+		}
+	} else if (f->isString()) {
+		switch (f->getType()) {
+		case ft_bytes:
+			writevalue = "json_string(json,$(field_value));\n";
+			break;
+		case ft_string:
+			if (0 == strcmp(f->getTypeName(),"BufView"))
+				// views are not \0 terminated
+				writevalue = "json_string(json,$(field_value));\n";
+			else
+				writevalue = "json_cstr(json,$(field_value).c_str());\n";
+			break;
+		case ft_cptr:
+			writevalue = "json_cstr(json,$(field_value));\n";
+			break;
+		default:
+			abort();
+		}
+	} else if (f->isMessage()) {
+		writevalue = "$(field_value).$(toJSON)(json,indLvl);\n";
+	} else {
+		abort();
+	}
+
+	switch (quan) {
+		break;
+	case q_optional:
+		G <<	"if ($(field_has)()) {\n";
+		if (fsep) {
+			G <<	"$json_indent(json,indLvl,'" << fsep << "',\"$fname\");\n";
+		} else {
+			G <<	"fsep = $json_indent(json,indLvl,fsep,\"$fname\");\n";
+		}
+		G <<	writevalue
+		<<	"}\n";
+		break;
+	case q_required:
+		if (fsep) {
+			G <<	"$json_indent(json,indLvl,'" << fsep << "',\"$fname\");\n";
+		} else {
+			G <<	"fsep = $json_indent(json,indLvl,fsep,\"$fname\");\n";
+		}
+		G <<	writevalue;
+		break;
+	case q_repeated:
+		G.addVariable("index","i");
+		G <<	"if (size_t s = $(field_size)) {\n";
+		if (fsep) {
+			G <<	"$json_indent(json,indLvl,'" << fsep << "');\n";
+		} else {
+			G <<	"fsep = $json_indent(json,indLvl,fsep);\n";
+		}
+		G <<	"indLvl += 2;\n"
+			"json << \"\\\"$(fname)\\\":[\\n\";\n"
+			"size_t i = 0;\n"
+			"for (;;) {\n"
+			"$json_indent(json,indLvl,0);\n"
+			<< writevalue <<
+			"++i;\n"
+			"if (i == s)\n"
+			"break;\n"
+			"json << \",\\n\";\n"
+			"}\n"
+			"indLvl -= 2;\n"
+			"json.put('\\n');\n"
+			"$json_indent(json,indLvl,0);\n"
+			"json.put(']');\n"
+			"}\n";
+		G.clearVariable("index");
+		break;
+	default:
+		abort();
+	}
+}
+
+
+static string resolve_esc(const string &s)
+{
+	string r;
+	const char *str = s.c_str();
+	while (char c = *str++) {
+		if (c == '\\') {
+			switch (char e = *str++) {
+			case 't':
+				r += '\t';
+				break;
 			case 'n':
 				r += '\n';
 				break;
 			case 'r':
 				r += '\r';
 				break;
-			case '\\':
-				r += '\\';
+			case '\\':
+				r += '\\';
+				break;
+			default:
+				r += '\\';
+				r += e;
+			}
+		} else {
+			r += c;
+		}
+	}
+	return r;
+}
+
+
+void CppGenerator::writeToJson(Generator &G, Message *m)
+{
+	// commaFlag is needed if first element is optional and more
+	// than one field is used in the message
+	char fsep = 0;	// fsepmode: 0 = '{', 1 = ',', 2 = fsep
+	const map<unsigned,Field *> &fields = m->getFields();
+	for (auto i : fields) {
+		Field *f = i.second;
+		if ((f == 0) || (!f->isUsed()))
+			continue;
+		if (f->getQuantifier() == q_required)
+			fsep = '{';
+		break;
+	}
+	G.addVariable("json_indent",resolve_esc(target->getOption("json_indent")));
+	G <<	"void $(prefix)$(msg_name)::$(toJSON)($(streamtype) &json, unsigned indLvl) const\n"
+		"{\n";
+	if (fsep == 0)
+		G <<	"char fsep = '{';\n";
+	G << "++indLvl;\n";
+	writeLazyAccess(G,m,"");
+
+	for (auto i = fields.begin(), e = fields.end(); i != e; ++i) {
+		Field *f = i->second;
+		if ((f == 0) || (!f->isUsed()) || f->isObsolete())
+			continue;
+		G.setField(f);
+		writeToJson(G,f,fsep);
+		if (fsep)
+			fsep = ',';
+		G.setField(0);
+	}
+	if (fsep == 0)
+		G <<	"if (fsep == '{')\n"
+			"json.put('{');\n";
+	G <<	"json.put('\\n');\n"
+		"--indLvl;\n"
+		"$json_indent(json,indLvl,0);\n"
+		"json.put('}');\n"
+		"if (indLvl == 0)\n"
+		"	json.put('\\n');\n"
+		"}\n"
+		"\n";
+	G.clearVariable("json_indent");
+}
+
+
+static int64_t jsonValueMaxSize(Field *f)
+{
+	// maximum number of characters of a value in JSON output,
+	// -1 if the size depends on the content
+	if (f->isEnum()) {
+		int64_t m = 20;
+		Enum *en = f->toEnum();
+		for (const auto &vn : en->getValueNamePairs()) {
+			int64_t l = vn.second.size() + 2;
+			if (const char *str = en->getStringValue(vn.first))
+				l = strlen(str);	// C literal: escapes only shorten the output
+			if (l > m)
+				m = l;
+		}
+		return m;
+	}
+	switch (f->getType()) {
+	case ft_bool:
+		return 5;
+	case ft_float:
+	case ft_double:
+		return 24;
+	case ft_int8:
+	case ft_sint8:
+	case ft_sfixed8:
+		return 4;
+	case ft_uint8:
+	case ft_fixed8:
+		return 3;
+	case ft_int16:
+	case ft_sint16:
+	case ft_sfixed16:
+		return 6;
+	case ft_uint16:
+	case ft_fixed16:
+		return 5;
+	case ft_int32:
+	case ft_sint32:
+	case ft_sfixed32:
+		return 11;
+	case ft_uint32:
+	case ft_fixed32:
+		return 10;
+	default:
+		if (f->isNumeric())
+			return 20;
+		return -1;
+	}
+}
+
+
+static bool jsonMaxSize(Message *m, int64_t &a, int64_t &b, vector<Message *> &stack)
+{
+	// maximum JSON size of m is a + b * indLvl (+1 on the top level)
+	if (find(stack.begin(),stack.end(),m) != stack.end())
+		return false;	// recursive message
+	stack.push_back(m);
+	a = 3;
+	b = 2;
+	bool r = true;
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed() || f->isObsolete())
+			continue;
+		if (f->getQuantifier() == q_repeated) {
+			r = false;
+			break;
+		}
+		a += strlen(f->getName()) + 7;
+		b += 2;
+		if (f->isMessage()) {
+			int64_t sa, sb;
+			if (!jsonMaxSize(Message::id2msg(f->getType()),sa,sb,stack)) {
+				r = false;
+				break;
+			}
+			a += sa + sb;
+			b += sb;
+		} else {
+			int64_t s = jsonValueMaxSize(f);
+			if (s < 0) {
+				r = false;
 				break;
-			default:
-				r += '\\';
-				r += e;
 			}
-		} else {
-			r += c;
+			a += s;
+		}
+	}
+	stack.pop_back();
+	return r;
+}
+
+
+void CppGenerator::writeToJsonBuffer(Generator &G, Field *f, char fsep)
+{
+	// same output as writeToJson, but stored directly to memory at a
+	uint8_t quan = f->getQuantifier();
+	uint32_t type = f->getType();
+	const char *writevalue = 0;
+	if (!f->getJsonFunction().empty())
+		error("option toJSONBuffer does not support the to_json function of field %s",f->getName());
+	if (f->isEnum()) {
+		writevalue =
+			"if (const char *v = $(strfun)($(field_value))) {\n"
+			"size_t l = strlen(v);\n"
+			"*a = '\"';\n"
+			"memcpy(a+1,v,l);\n"
+			"a[l+1] = '\"';\n"
+			"a += l+2;\n"
+			"} else {\n"
+			"a = json_buf_decstr(a,(int64_t) $(field_value));\n"
+			"}\n";
+	} else if (type == ft_bool) {
+		writevalue =
+			"if ($(field_value)) {\n"
+			"memcpy(a,\"true\",4);\n"
+			"a += 4;\n"
+			"} else {\n"
+			"memcpy(a,\"false\",5);\n"
+			"a += 5;\n"
+			"}\n";
+	} else if (f->isNumeric()) {
+		if ((type == ft_float) || (type == ft_double))
+			writevalue = "a = json_buf_dblstr(a,$(field_value));\n";
+		else if ((type == ft_int8) || (type == ft_sint8) || (type == ft_sfixed8))
+			writevalue = "a = json_buf_decstr(a,(int) $(field_value));\n";
+		else if ((type == ft_uint8) || (type == ft_fixed8))
+			writevalue = "a = json_buf_decstr(a,(unsigned) $(field_value));\n";
+		else
+			writevalue = "a = json_buf_decstr(a,$(field_value));\n";
+	} else if (f->isString()) {
+		switch (type) {
+		case ft_bytes:
+			writevalue = "a = json_buf_string(a,$(field_value));\n";
+			break;
+		case ft_string:
+			if (0 == strcmp(f->getTypeName(),"BufView"))
+				// views are not \0 terminated
+				writevalue = "a = json_buf_string(a,$(field_value));\n";
+			else
+				writevalue = "a = json_buf_cstr(a,$(field_value).c_str());\n";
+			break;
+		case ft_cptr:
+			writevalue = "a = json_buf_cstr(a,$(field_value));\n";
+			break;
+		default:
+			abort();
+		}
+	} else if (f->isMessage()) {
+		writevalue = "a = $(field_value).$(toJSONBuffer)Unchecked(a,indLvl);\n";
+	} else {
+		abort();
+	}
+
+	switch (quan) {
+	case q_optional:
+	case q_required:
+		if (quan == q_optional)
+			G <<	"if ($(field_has)()) {\n";
+		if (fsep)
+			G <<	"a = json_buf_key(a,indLvl,'" << fsep << "',\"\\\"$(fname)\\\":\",$fnamelen+3);\n";
+		else
+			G <<	"a = json_buf_key(a,indLvl,fsep,\"\\\"$(fname)\\\":\",$fnamelen+3);\n"
+				"fsep = ',';\n";
+		G <<	writevalue;
+		if (quan == q_optional)
+			G <<	"}\n";
+		break;
+	case q_repeated:
+		G.addVariable("index","i");
+		G <<	"if (size_t s = $(field_size)) {\n";
+		if (fsep)
+			G <<	"a = json_buf_key(a,indLvl,'" << fsep << "',\"\\\"$(fname)\\\":[\\n\",$fnamelen+5);\n";
+		else
+			G <<	"a = json_buf_key(a,indLvl,fsep,\"\\\"$(fname)\\\":[\\n\",$fnamelen+5);\n"
+				"fsep = ',';\n";
+		G <<	"indLvl += 2;\n"
+			"size_t i = 0;\n"
+			"for (;;) {\n"
+			"a = json_buf_key(a,indLvl,0,\"\",0);\n"
+			<< writevalue <<
+			"++i;\n"
+			"if (i == s)\n"
+			"break;\n"
+			"a[0] = ',';\n"
+			"a[1] = '\\n';\n"
+			"a += 2;\n"
+			"}\n"
+			"indLvl -= 2;\n"
+			"*a++ = '\\n';\n"
+			"a = json_buf_key(a,indLvl,0,\"\",0);\n"
+			"*a++ = ']';\n"
+			"}\n";
+		G.clearVariable("index");
+		break;
+	default:
+		abort();
+	}
+}
+
+
+void CppGenerator::writeToJsonBuffer(Generator &G, Message *m)
+{
+	// field separator handling as in writeToJson
+	char fsep = 0;
+	const map<unsigned,Field *> &fields = m->getFields();
+	for (auto i : fields) {
+		Field *f = i.second;
+		if ((f == 0) || (!f->isUsed()))
+			continue;
+		if (f->getQuantifier() == q_required)
+			fsep = '{';
+		break;
+	}
+	G <<	"char *$(prefix)$(msg_name)::$(toJSONBuffer)Unchecked(char *a, unsigned indLvl) const\n"
+		"{\n";
+	if (fsep == 0)
+		G <<	"char fsep = '{';\n";
+	G << "++indLvl;\n";
+	writeLazyAccess(G,m,"");
+	for (auto i = fields.begin(), e = fields.end(); i != e; ++i) {
+		Field *f = i->second;
+		if ((f == 0) || (!f->isUsed()) || f->isObsolete())
+			continue;
+		G.setField(f);
+		writeToJsonBuffer(G,f,fsep);
+		if (fsep)
+			fsep = ',';
+		G.setField(0);
+	}
+	if (fsep == 0)
+		G <<	"if (fsep == '{')\n"
+			"	*a++ = '{';\n";
+	G <<	"*a++ = '\\n';\n"
+		"--indLvl;\n"
+		"a = json_buf_key(a,indLvl,0,\"\",0);\n"
+		"*a++ = '}';\n"
+		"if (indLvl == 0)\n"
+		"	*a++ = '\\n';\n"
+		"return a;\n"
+		"}\n"
+		"\n";
+	if (WithComments)
+		G <<	"/*\n"
+			" * The output is written unchecked, if $(calcJSONSize) fits the\n"
+			" * buffer. Otherwise it is written to a temporary buffer first.\n"
+			" */\n";
+	G <<	"ssize_t $(prefix)$(msg_name)::$(toJSONBuffer)(char *b, size_t n) const\n"
+		"{\n"
+		"size_t s = $(calcJSONSize)();\n"
+		"if (s <= n)\n"
+		"	return $(toJSONBuffer)Unchecked(b) - b;\n"
+		"char *t = (char *) malloc(s);\n"
+		"if (t == 0)\n"
+		"	$handle_error;\n"
+		"size_t l = $(toJSONBuffer)Unchecked(t) - t;\n"
+		"if (l <= n)\n"
+		"	memcpy(b,t,l);\n"
+		"free(t);\n"
+		"if (l > n)\n"
+		"	$handle_error;\n"
+		"return l;\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeCalcJsonSize(Generator &G, Message *m)
+{
+	G <<	"size_t $(prefix)$(msg_name)::$(calcJSONSize)(unsigned indLvl) const\n"
+		"{\n";
+	if (WithComments)
+		G <<	"// '{' of an empty object, newline, indention, '}', and newline on top level\n";
+	G <<	"size_t r = 3 + 2*indLvl + (indLvl == 0);\n"
+		"++indLvl;\n";
+	writeLazyAccess(G,m,"");
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || (!f->isUsed()) || f->isObsolete())
+			continue;
+		G.setField(f);
+		uint32_t type = f->getType();
+		int64_t vs = jsonValueMaxSize(f);
+		string value;
+		if (vs >= 0) {
+			char buf[32];
+			sprintf(buf,"%" PRId64,vs);
+			value = buf;
+		} else if (f->isMessage()) {
+			value = (f->getQuantifier() == q_repeated) ? "$(field_value).$(calcJSONSize)(indLvl+2)" : "$(field_value).$(calcJSONSize)(indLvl)";
+		} else if ((type == ft_bytes) || ((type == ft_string) && (0 == strcmp(f->getTypeName(),"BufView")))) {
+			value = "json_strsize($(field_value))";
+		} else if (type == ft_string) {
+			value = "json_cstrsize($(field_value).c_str())";
+		} else if (type == ft_cptr) {
+			value = "json_cstrsize($(field_value))";
+		} else {
+			abort();
+		}
+		switch (f->getQuantifier()) {
+		case q_optional:
+			G <<	"if ($(field_has)())\n"
+				"	r += $fnamelen + 5 + 2*indLvl + " << value << ";\n";
+			break;
+		case q_required:
+			G <<	"r += $fnamelen + 5 + 2*indLvl + " << value << ";\n";
+			break;
+		case q_repeated:
+			G.addVariable("index","i");
+			G <<	"if (size_t s = $(field_size)) {\n"
+				"r += $fnamelen + 7 + 4*indLvl + s*(2*indLvl+6);\n";
+			if (vs >= 0)
+				G <<	"r += s*" << value << ";\n";
+			else
+				G <<	"for (size_t i = 0; i != s; ++i)\n"
+					"	r += " << value << ";\n";
+			G <<	"}\n";
+			G.clearVariable("index");
+			break;
+		default:
+			abort();
+		}
+		G.setField(0);
+	}
+	G <<	"return r;\n"
+		"}\n"
+		"\n";
+}
+
+
+void CppGenerator::writeMaxJsonSize(Generator &G, Message *m)
+{
+	G <<	"size_t $(prefix)$(msg_name)::$(maxJSONSize)(unsigned indLvl)\n"
+		"{\n";
+	int64_t a, b;
+	vector<Message *> stack;
+	if (jsonMaxSize(m,a,b,stack)) {
+		if (WithComments)
+			G <<	"// fixed part, indention of fields, and newline on top level\n";
+		G <<	"return " << a << " + " << b << "*indLvl + (indLvl == 0);\n";
+	} else {
+		if (WithComments)
+			G <<	"// strings, repeated, or recursive fields have no size limit\n";
+		G <<	"return SIZE_MAX;\n";
+	}
+	G <<	"}\n"
+		"\n";
+}
+
+
+static bool parsesJson(Field *f)
+{
+	if ((f == 0) || !f->isUsed() || f->isObsolete() || f->isVirtual())
+		return false;
+	if (!f->getJsonFunction().empty())
+		return false;	// custom output format
+	uint32_t t = f->getType();
+	if (t == ft_cptr)
+		return false;	// no storage for the parsed data
+	if (((t == ft_string) || (t == ft_bytes)) && (0 == strcmp(f->getTypeName(),"BufView")))
+		return false;	// no storage for the parsed data
+	return true;
+}
+
+
+void CppGenerator::writeFromJson(Generator &G, Field *f, bool rep)
+{
+	// parse the value at a and assign it to the member or
+	// append it to the repeated member
+	uint32_t t = f->getType();
+	const char *store = rep ? "m_$(fname).push_back(($(typestr)) v);\n" : "m_$(fname) = ($(typestr)) v;\n";
+	if (f->isEnum()) {
+		G <<	"int64_t v;\n"
+			"if (*a == '\"') {\n"
+			"const char *s;\n"
+			"size_t l;\n"
+			"bool esc;\n"
+			"a = json_parse_string(a,e,&s,&l,&esc);\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n";
+		Enum *en = f->toEnum();
+		const char *elif = "if";
+		for (const auto &vn : en->getValueNamePairs()) {
+			char buf[64];
+			sprintf(buf,"%" PRId64,vn.first);
+			G <<	elif << " ((l == " << vn.second.size() << ") && (0 == memcmp(s,\"" << vn.second << "\"," << vn.second.size() << ")))\n"
+				"	v = " << buf << ";\n";
+			elif = "else if";
+		}
+		for (const auto &vn : en->getValueNamePairs()) {
+			if (const char *str = en->getStringValue(vn.first)) {
+				char buf[64];
+				sprintf(buf,"%" PRId64,vn.first);
+				G <<	elif << " ((l == sizeof(" << str << ")-1) && (0 == memcmp(s," << str << ",l)))\n"
+					"	v = " << buf << ";\n";
+			}
+		}
+		G <<	"else\n"
+			"	$handle_error;\n"
+			"} else {\n"
+			"a = json_parse_int(a,e,&v);\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n"
+			"}\n"
+		<<	store;
+		return;
+	}
+	switch (t) {
+	case ft_bool:
+		G <<	"bool v;\n"
+			"a = json_parse_bool(a,e,&v);\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n"
+		<<	store;
+		break;
+	case ft_float:
+	case ft_double:
+		G <<	"double v;\n"
+			"a = json_parse_dbl(a,e,&v);\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n"
+		<<	store;
+		break;
+	case ft_int8:
+	case ft_sint8:
+	case ft_sfixed8:
+	case ft_int16:
+	case ft_sint16:
+	case ft_sfixed16:
+	case ft_int32:
+	case ft_sint32:
+	case ft_sfixed32:
+	case ft_int64:
+	case ft_sint64:
+	case ft_sfixed64:
+		G <<	"int64_t v;\n"
+			"a = json_parse_int(a,e,&v);\n"
+			"if ((a == 0) || ((int64_t)($(typestr)) v != v))\n"
+			"	$handle_error;\n"
+		<<	store;
+		break;
+	case ft_uint8:
+	case ft_fixed8:
+	case ft_uint16:
+	case ft_fixed16:
+	case ft_uint32:
+	case ft_fixed32:
+	case ft_uint64:
+	case ft_fixed64:
+		G <<	"uint64_t v;\n"
+			"a = json_parse_uint(a,e,&v);\n"
+			"if ((a == 0) || ((uint64_t)($(typestr)) v != v))\n"
+			"	$handle_error;\n"
+		<<	store;
+		break;
+	case ft_string:
+	case ft_bytes:
+		G <<	"const char *s;\n"
+			"size_t l;\n"
+			"bool esc;\n"
+			"a = json_parse_string(a,e,&s,&l,&esc);\n"
+			"if (a == 0)\n"
+			"	$handle_error;\n";
+		if (rep)
+			G <<	"m_$(fname).emplace_back();\n"
+				"if (json_assign_string(m_$(fname).back(),s,l,esc))\n";
+		else
+			G <<	"if (json_assign_string(m_$(fname),s,l,esc))\n";
+		G <<	"	$handle_error;\n";
+		break;
+	default:
+		if ((t & ft_filter) != ft_msg)
+			abort();
+		if (rep)
+			G <<	"m_$(fname).emplace_back();\n"
+				"ssize_t r = m_$(fname).back().$(fromJSON)(a,e-a);\n";
+		else
+			G <<	"ssize_t r = m_$(fname).$(fromJSON)(a,e-a);\n";
+		G <<	"if (r < 0)\n"
+			"	return r;\n"
+			"a += r;\n";
+	}
+}
+
+
+void CppGenerator::writeFromJson(Generator &G, Message *m)
+{
+	// group the keys by length for the dispatch
+	map<size_t,vector<Field *>> keys;
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if (parsesJson(f))
+			keys[strlen(f->getName())].push_back(f);
+	}
+	if (WithComments)
+		G <<	"/*\n"
+			" * Keys are dispatched by their length and then compared to the\n"
+			" * field names. Escaped keys are decoded first. Values are parsed\n"
+			" * in place from the input.\n"
+			" */\n";
+	G <<	"ssize_t $(prefix)$(msg_name)::$(fromJSON)(const char *json, size_t n)\n"
+		"{\n"
+		"const char *a = json, *e = json + n;\n"
+		"a = json_skip_ws(a,e);\n"
+		"if ((a == e) || (*a != '{'))\n"
+		"	$handle_error;\n"
+		"a = json_skip_ws(a+1,e);\n"
+		"if ((a != e) && (*a == '}'))\n"
+		"	return a+1-json;\n"
+		"for (;;) {\n"
+		"const char *k;\n"
+		"size_t kl;\n"
+		"bool esc;\n"
+		"a = json_parse_string(a,e,&k,&kl,&esc);\n"
+		"if (a == 0)\n"
+		"	$handle_error;\n"
+		"a = json_skip_ws(a,e);\n"
+		"if ((a == e) || (*a != ':'))\n"
+		"	$handle_error;\n"
+		"a = json_skip_ws(a+1,e);\n"
+		"if (a == e)\n"
+		"	$handle_error;\n";
+	if (!keys.empty()) {
+		// an escape sequence takes at most 6 bytes per character
+		G <<	"char kb[" << keys.rbegin()->first*6 << "];\n"
+			"if (esc && (kl <= sizeof(kb))) {\n"
+			"ssize_t x = json_unescape(kb,k,kl);\n"
+			"if (x < 0)\n"
+			"	$handle_error;\n"
+			"kl = x;\n"
+			"k = kb;\n"
+			"}\n"
+			"unsigned fid = 0;\n"
+			"switch (kl) {\n";
+		for (const auto &k : keys) {
+			G << "case " << k.first << ":\n";
+			const char *elif = "if";
+			for (Field *f : k.second) {
+				G.setField(f);
+				G <<	elif << " (0 == memcmp(k,\"$(fname)\",$fnamelen))\n"
+					"	fid = $(field_id);\n";
+				G.setField(0);
+				elif = "else if";
+			}
+			G << "break;\n";
+		}
+		G <<	"}\n"
+			"switch (fid) {\n";
+		for (auto i : m->getFields()) {
+			Field *f = i.second;
+			if (parsesJson(f)) {
+				G.setField(f);
+				G <<	"case $(field_id): {\n";
+				if (f->isLazy())
+					G << "lazy_decode_$(fname)();\n";
+				G <<	"if ((e-a >= 4) && (0 == memcmp(a,\"null\",4))) {\n"
+					"a += 4;\n";
+				if (f->getQuantifier() != q_required)
+					G << "$(field_clear)();\n";
+				G <<	"break;\n"
+					"}\n";
+				if (f->getQuantifier() == q_repeated) {
+					G <<	"if (*a != '[')\n"
+						"	$handle_error;\n"
+						"m_$(fname).clear();\n"
+						"a = json_skip_ws(a+1,e);\n"
+						"if ((a != e) && (*a == ']')) {\n"
+						"++a;\n"
+						"break;\n"
+						"}\n"
+						"for (;;) {\n"
+						"if (a == e)\n"
+						"	$handle_error;\n";
+					writeFromJson(G,f,true);
+					G <<	"a = json_skip_ws(a,e);\n"
+						"if (a == e)\n"
+						"	$handle_error;\n"
+						"if (*a == ']')\n"
+						"	break;\n"
+						"if (*a != ',')\n"
+						"	$handle_error;\n"
+						"a = json_skip_ws(a+1,e);\n"
+						"}\n"
+						"++a;\n";
+				} else {
+					writeFromJson(G,f,false);
+					writeSetValid(G,f->getValidBit());
+				}
+				// only successfully parsed values are marked dirty
+				G <<	setDirty(f)
+				<<	"break;\n"
+					"}\n";
+				G.setField(0);
+			}
 		}
+		G <<	"default:\n";
 	}
-	return r;
+	G <<	"a = json_skip_value(a,e);\n"
+		"if (a == 0)\n"
+		"	$handle_error;\n";
+	if (!keys.empty())
+		G <<	"}\n";
+	G <<	"a = json_skip_ws(a,e);\n"
+		"if (a == e)\n"
+		"	$handle_error;\n"
+		"if (*a == '}')\n"
+		"	return a+1-json;\n"
+		"if (*a != ',')\n"
+		"	$handle_error;\n"
+		"a = json_skip_ws(a+1,e);\n"
+		"}\n"
+		"}\n"
+		"\n";
 }
 
 
-void CppGenerator::writeToJson(Generator &G, Message *m)
+void CppGenerator::writeToX(Generator &G, Message *m)
 {
-	// commaFlag is needed if first element is optional and more
-	// than one field is used in the message
-	char fsep = 0;	// fsepmode: 0 = '{', 1 = ',', 2 = fsep
-	const map<unsigned,Field *> &fields = m->getFields();
-	for (auto i : fields) {
+	assert(G.hasValue("toX"));
+	G <<	"$(sink_template)void $(prefix)$(msg_name)::$(toX)($putparam) const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toX)($(putparam))\\n\";\n";
+	for (auto i : m->getFields()) {
 		Field *f = i.second;
 		if ((f == 0) || (!f->isUsed()))
 			continue;
-		if (f->getQuantifier() == q_required)
-			fsep = '{';
-		break;
+		writeToX(G,f);
 	}
-	G.addVariable("json_indent",resolve_esc(target->getOption("json_indent")));
-	G <<	"void $(prefix)$(msg_name)::$(toJSON)($(streamtype) &json, unsigned indLvl) const\n"
-		"{\n";
-	if (fsep == 0)
-		G <<	"char fsep = '{';\n";
-	G << "++indLvl;\n";
+	writeTerminator(G,0,"$wireput($(terminator));\n");
+	G <<	"}\n"
+		"\n";
+}
 
-	for (auto i = fields.begin(), e = fields.end(); i != e; ++i) {
-		Field *f = i->second;
-		if ((f == 0) || (!f->isUsed()) || f->isObsolete())
+
+void CppGenerator::writeWireFlush(Generator &G)
+{
+	G <<	"if (a != b) {\n"
+		"$wirewrite(b,a-b);\n"
+		"a = b;\n"
+		"}\n";
+}
+
+
+void CppGenerator::writeToWireBlock(Generator &G, Message *m)
+{
+	// serialize to a staging buffer that is passed on block-wise
+	G <<	"void $(prefix)$(msg_name)::$(toWire)() const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toWire)()\\n\";\n";
+	G <<	"uint8_t b[64], *a = b;\n";
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed())
 			continue;
-		G.setField(f);
-		writeToJson(G,f,fsep);
-		if (fsep)
-			fsep = ',';
-		G.setField(0);
+		writeToBlock(G,blk_wire,f);
 	}
-	if (fsep == 0)
-		G <<	"if (fsep == '{')\n"
-			"json.put('{');\n";
-	G <<	"json.put('\\n');\n"
-		"--indLvl;\n"
-		"$json_indent(json,indLvl,0);\n"
-		"json.put('}');\n"
-		"if (indLvl == 0)\n"
-		"	json.put('\\n');\n"
+	writeBlockTerminator(G,blk_wire);
+	G <<	"if (a != b)\n"
+		"	$wirewrite(b,a-b);\n"
 		"}\n"
 		"\n";
-	G.clearVariable("json_indent");
 }
 
 
-void CppGenerator::writeToX(Generator &G, Message *m)
+void CppGenerator::writeToIovec(Generator &G, Message *m)
 {
-	assert(G.hasValue("toX"));
-	G <<	"$(sink_template)void $(prefix)$(msg_name)::$(toX)($putparam) const\n"
+	G <<	"ssize_t $(prefix)$(msg_name)::$(toIovec)(IovecBuilder &v) const\n"
 		"{\n";
 	if (Debug)
-		G << "std::cout << \"$(prefix)$(msg_name)::$(toX)($(putparam))\\n\";\n";
-	for (auto i : m->getFields()) {
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toIovec)()\\n\";\n";
+	bool hasData = (terminatorByte() >= 0);
+	for (const auto &i : m->getFields()) {
 		Field *f = i.second;
-		if ((f == 0) || (!f->isUsed()))
+		if (f && f->isUsed() && !f->isDeprecated() && !f->isObsolete())
+			hasData = true;
+	}
+	G <<	"size_t s = v.getSize();\n";
+	if (hasData)
+		G <<	"uint8_t *a;\n";
+	for (const auto &i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed())
 			continue;
-		writeToX(G,f);
+		writeToBlock(G,blk_iovec,f);
 	}
-	const string &Terminator = target->getOption("Terminator");
-	if ((Terminator == "ff") || (Terminator == "0xff")) {
-		if (WithComments)
-			G << "// write terminating ff byte\n";
-		G << "$wireput(0xff);\n";
-	} else if ((Terminator == "null") || (Terminator == "0")) {
-		if (WithComments)
-			G << "// write terminating null byte\n";
-		G << "$wireput(0);\n";
+	writeBlockTerminator(G,blk_iovec);
+	G <<	"return v.getSize()-s;\n"
+		"}\n"
+		"\n";
+}
+
+
+bool CppGenerator::presizeToString()
+{
+	// toString serializes via toMemory if available, but this requires
+	// resize and operator [] that user defined stringtypes may lack
+	if (!target->isId("toMemory") && !target->isId("toMemoryUnchecked"))
+		return false;
+	const string &st = target->getOption("stringtype");
+	return (st == "std::string") || (st == "AString");
+}
+
+
+void CppGenerator::writeToString(Generator &G, Message *m)
+{
+	// size the string once and serialize to its storage
+	G <<	"void $(prefix)$(msg_name)::$(toString)($putparam) const\n"
+		"{\n";
+	if (Debug)
+		G << "std::cout << \"$(prefix)$(msg_name)::$(toString)($(putparam))\\n\";\n";
+	if (terminatorByte() >= 0)
+		G <<	"size_t s = $calcSize() + 1;\n";
+	else
+		G <<	"size_t s = $calcSize();\n";
+	// on failure put is restored to its previous content
+	G <<	"size_t o = put.size();\n"
+		"put.resize(o+s);\n"
+		"if (put.size() != o+s)\n"
+		"	return;\n";
+	if (G.hasValue("toMemoryUnchecked")) {
+		if (Asserts)
+			G <<	"ssize_t n = $(toMemoryUnchecked)((uint8_t*)&put[o]);\n"
+				"assert(n == (ssize_t)s);\n";
+		else
+			G <<	"$(toMemoryUnchecked)((uint8_t*)&put[o]);\n";
+	} else {
+		G <<	"if ($toMemory((uint8_t*)&put[o],s) < 0)\n"
+			"	put.resize(o);\n";
 	}
 	G <<	"}\n"
 		"\n";
@@ -4075,6 +7004,9 @@ void CppGenerator::writeClear(Generator &G, Message *m)
 		} else {
 			G << "m_$(fname) = 0;\n";
 		}
+		if (f->isLazy())
+			G <<	"lazy_$(fname) = 0;\n"
+				"lazyused_$(fname) = false;\n";
 		G.setField(0);
 	}
 	G.clearVariable("fname");
@@ -4093,10 +7025,48 @@ void CppGenerator::writeClear(Generator &G, Message *m)
 }
 
 
+void CppGenerator::writeLazyDecode(Generator &G, Field *f)
+{
+	G.setField(f);
+	if (WithComments)
+		G <<	"/*\n"
+			" * Decodes $(fname) from the data recorded by $(fromMemory).\n"
+			" * The framing has been checked when recording the data. Other\n"
+			" * decoding errors are reported according to the error handling\n"
+			" * option of $(fromMemory), but cannot be returned to the caller.\n"
+			" */\n";
+	G <<	"void $(prefix)$(msg_name)::lazy_decode_$(fname)() const\n"
+		"{\n"
+		"lazyused_$(fname) = true;\n"
+		"if (lazy_$(fname)) {\n"
+		"const uint8_t *b = lazy_$(fname);\n"
+		"lazy_$(fname) = 0;\n"
+		"m_$(fname).$(fromMemory)(b,lazysize_$(fname));\n"
+		"}\n"
+		"}\n\n";
+	G.setField(0);
+}
+
+
+void CppGenerator::writeLazyAccess(Generator &G, Message *m, const char *obj)
+{
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if ((f == 0) || !f->isUsed() || f->isObsolete() || !f->isLazy())
+			continue;
+		G.setField(f);
+		G << obj << "lazy_decode_$(fname)();\n";
+		G.setField(0);
+	}
+}
+
+
 void CppGenerator::writeUnequal(Generator &G, Message *m)
 {
 	G <<	"bool $(prefix)$(msg_name)::operator != (const $(prefix)$(msg_name) &r) const\n"
 		"{\n";
+	writeLazyAccess(G,m,"");
+	writeLazyAccess(G,m,"r.");
 	if (optmode != optreview) {
 		unsigned nv = m->getNumValid();
 		if (nv == 0) {
@@ -4167,6 +7137,8 @@ void CppGenerator::writeEqual(Generator &G, Message *m)
 {
 	G <<	"bool $(prefix)$(msg_name)::operator == (const $(prefix)$(msg_name) &r) const\n"
 		"{\n";
+	writeLazyAccess(G,m,"");
+	writeLazyAccess(G,m,"r.");
 	if (optmode != optreview) {
 		unsigned nv = m->getNumValid();
 		if (nv == 0) {
@@ -4395,6 +7367,7 @@ void CppGenerator::writePrint(Generator &G, Message *m)
 //		"$ascii_indent(o,indent);\n"
 		"o << \"$(msg_name) {\";\n"
 		"++indent;\n";
+	writeLazyAccess(G,m,"");
 	for (auto i : m->getFields()) {
 		Field *f = i.second;
 		if ((f == 0) || (!f->isUsed()) || f->isObsolete())
@@ -4435,6 +7408,11 @@ void CppGenerator::writeFunctions(Generator &G, Message *m)
 	if (optmode == optsize)
 		writeConstructor(G,m);
 	writeClear(G,m);
+	for (auto i : m->getFields()) {
+		Field *f = i.second;
+		if (f && f->isUsed() && !f->isObsolete() && f->isLazy())
+			writeLazyDecode(G,f);
+	}
 	// ::calcSize needed in all sender functions for writing message/field size into stream
 	if (!inlineMaxSize)
 		writeMaxSize(G,m);
@@ -4445,13 +7423,33 @@ void CppGenerator::writeFunctions(Generator &G, Message *m)
 			writeFromMemory_early(G,m);
 		else
 			writeFromMemory(G,m);
-	}
+		if (WithFieldMask)
+			writeFromMemoryMask(G,m);
+		if (WithMerge)
+			writeMergeFromMemory(G,m);
+		if (WithParser)
+			writeParser(G,m);
+	}
+	if (G.hasValue("validate"))
+		writeValidate(G,m);
 	if (G.hasValue("toMemory"))
 		writeToMemory(G,m);
+	if (G.hasValue("toMemoryReverse"))
+		writeToMemoryReverse(G,m);
+	if (WithDelta)
+		writeToMemoryDelta(G,m);
+	if (G.hasValue("toMemoryUnchecked"))
+		writeToMemoryUnchecked(G,m);
+	if (G.hasValue("toIovec"))
+		writeToIovec(G,m);
 	if (G.hasValue("toWire")) {
 		G.setMode(gen_wire);
-		G.setVariable("toX",G.getVariable("toWire"));
-		writeToX(G,m);
+		if (G.hasValue("wirewrite")) {
+			writeToWireBlock(G,m);
+		} else {
+			G.setVariable("toX",G.getVariable("toWire"));
+			writeToX(G,m);
+		}
 	}
 	if (G.hasValue("toSink") && !SinkToTemplate) {
 		G.setMode(gen_sink);
@@ -4460,11 +7458,22 @@ void CppGenerator::writeFunctions(Generator &G, Message *m)
 	}
 	if (G.hasValue("toString")) {
 		G.setMode(gen_string);
-		G.setVariable("toX",G.getVariable("toString"));
-		writeToX(G,m);
+		if (presizeToString()) {
+			writeToString(G,m);
+		} else {
+			G.setVariable("toX",G.getVariable("toString"));
+			writeToX(G,m);
+		}
 	}
 	if (G.hasValue("toJSON"))
 		writeToJson(G,m);
+	if (G.hasValue("fromJSON"))
+		writeFromJson(G,m);
+	if (G.hasValue("toJSONBuffer")) {
+		writeToJsonBuffer(G,m);
+		writeCalcJsonSize(G,m);
+		writeMaxJsonSize(G,m);
+	}
 	if (needCalcSize)
 		writeCalcSize(G,m);
 	
@@ -4512,6 +7521,37 @@ void CppGenerator::writeHelpers(vector<unsigned> &funcs)
 		if (hasFloat || hasDouble)
 			funcs.push_back(ct_to_dblstr);
 	}
+	if (target->isId("fromJSON")) {
+		funcs.push_back(ct_json_skip_ws);
+		funcs.push_back(ct_json_parse_string);
+		funcs.push_back(ct_json_skip_value);
+		if (hasEnums || hasS8 || hasS16 || hasS32 || hasS64)
+			funcs.push_back(ct_json_parse_int);
+		if (hasU8 || hasU16 || hasU32 || hasU64)
+			funcs.push_back(ct_json_parse_uint);
+		if (hasFloat || hasDouble)
+			funcs.push_back(ct_json_parse_dbl);
+		if (hasBool)
+			funcs.push_back(ct_json_parse_bool);
+		// also needed for escaped keys
+		funcs.push_back(ct_json_unescape);
+		if (hasString || hasBytes)
+			funcs.push_back(ct_json_assign_string);
+	}
+	if (target->isId("toJSONBuffer")) {
+		funcs.push_back(ct_json_buf_key);
+		funcs.push_back(ct_json_buf_decstr);
+		if (hasFloat || hasDouble)
+			funcs.push_back(ct_json_buf_dblstr);
+		if (hasString || hasBytes) {
+			funcs.push_back(ct_json_buf_string);
+			funcs.push_back(ct_json_strsize);
+		}
+		if (hasCStr || hasString) {
+			funcs.push_back(ct_json_buf_cstr);
+			funcs.push_back(ct_json_cstrsize);
+		}
+	}
 
 	if (PrintOut) {
 		if (target->getOption("ascii_indent") == "ascii_indent")
@@ -4566,18 +7606,37 @@ void CppGenerator::writeHelpers(vector<unsigned> &funcs)
 		funcs.push_back(ct_wiresize_x);
 	}
 
-	if (target->isId("toMemory")) {
+	// block-wise toWire and toIovec encode like toMemoryUnchecked
+	bool encodeUnchecked = target->isId("toMemoryUnchecked") || target->isId("toIovec")
+		|| (target->isId("toWire") && target->isId("wirewrite"));
+	if (target->isId("toMemory") || target->isId("toMemoryReverse") || encodeUnchecked) {
 		if (hasWT16)
 			funcs.push_back(ct_write_u16);
 		if (hasWT32 || hasFloat)
 			funcs.push_back(ct_write_u32);
 		if (hasWT64 || hasDouble)
 			funcs.push_back(ct_write_u64);
+	}
+	if (target->isId("toMemory") || target->isId("toMemoryReverse") || target->isId("toMemoryUnchecked")) {
 		if (hasBytes || hasString)
 			funcs.push_back(ct_encode_bytes);
 	}
 
-	if (target->isId("toMemory") || target->isId("toWire")) {
+	if (target->isId("toMemoryReverse")) {
+		funcs.push_back(ct_rwrite_varint);
+		if (needSendVarSInt)
+			funcs.push_back(ct_rwrite_xvarint);
+	}
+
+	if (encodeUnchecked) {
+		funcs.push_back(ct_uwrite_varint);
+		if (needSendVarSInt)
+			funcs.push_back(ct_uwrite_xvarint);
+		if (PaddedMsgSize && hasLenPfx && !target->isId("toMemory"))
+			funcs.push_back(ct_place_varint);
+	}
+
+	if (target->isId("toMemory") || target->isId("toMemoryReverse") || encodeUnchecked || target->isId("toWire")) {
 		if (hasFloat)
 			funcs.push_back(ct_mangle_float);
 		if (hasDouble)
@@ -4588,6 +7647,12 @@ void CppGenerator::writeHelpers(vector<unsigned> &funcs)
 		funcs.push_back(ct_read_varint);
 		if (((target->getOption("UnknownField") == "skip") || ((optmode != optspeed) && hasUnused)) && (!EarlyDecode))
 			funcs.push_back(ct_skip_content);
+		else if (WithFieldMask || WithMerge || hasLazy)
+			funcs.push_back(ct_skip_content);
+		if ((target->getOption("UnknownField") == "skip") && (optmode == optspeed) && !EarlyDecode) {
+			if (terminatorByte() < 0)
+				funcs.push_back(ct_skip_fields);
+		}
 		if (hasDouble && !EarlyDecode)
 			funcs.push_back(ct_read_double);
 		else if (hasDoubles)	// for repeated floats with early decode
@@ -4609,10 +7674,12 @@ void CppGenerator::writeHelpers(vector<unsigned> &funcs)
 		if ((hasRBytes || hasRString) && (target->getOption("stringtype") != "C"))
 			funcs.push_back(ct_decode_bytes_element);
 	}
+	if (target->isId("validate") && !target->isId("fromMemory"))
+		funcs.push_back(ct_read_varint);
 	
 	// mode specific implementations
 	unsigned mode = 0;
-	if (target->isId("toWire")) {
+	if (target->isId("toWire") && !target->isId("wirewrite")) {
 		funcs.push_back(gen_wire);
 		mode = gen_wire;
 		if (hasWT16)
@@ -4622,7 +7689,7 @@ void CppGenerator::writeHelpers(vector<unsigned> &funcs)
 		if (hasWT64 || hasDouble)
 			funcs.push_back(ct_send_u64);
 	}
-	if (target->isId("toString")) {
+	if (target->isId("toString") && !presizeToString()) {
 		funcs.push_back(gen_string);
 		mode = gen_string;
 		if (hasWT16)
@@ -4640,7 +7707,7 @@ void CppGenerator::writeHelpers(vector<unsigned> &funcs)
 			funcs.push_back(ct_send_xvarint);
 	}
 
-	if (target->isId("toWire")) {
+	if (target->isId("toWire") && !target->isId("wirewrite")) {
 		if (mode != gen_wire) {
 			funcs.push_back(gen_wire);
 			mode = gen_wire;
@@ -4738,7 +7805,7 @@ void CppGenerator::writeBody(const string &bn)
 		Lib.write_cpp(G,funcs,target);
 	}
 
-	needCalcSize = (target->isId("toSink") || target->isId("toMemory") || target->isId("toWire") || target->isId("toString"));
+	needCalcSize = (target->isId("toSink") || target->isId("toMemory") || target->isId("toWire") || target->isId("toString") || target->isId("toIovec"));
 	G.setVariable("inline","");
 	for (Enum *e : file->getEnums())
 		writeEnumDefs(G,e);
@@ -4769,61 +7836,68 @@ void CppGenerator::writeFromMemory_early(Generator &G, Field *f)
 	if (f->isPacked()) {
 		G.setVariableHex("field_tag",(int64_t)id<<3|2);
 		G <<	"case $(field_tag): {\t// $(fname) id $(field_id), packed $(typestr)[] coding 2\n"
-			"varint_t v = ud.u64;\n"
-			"const uint8_t *ae = a + v;\n"
-			"do {\n";
-		switch (type) {
-		default:
-		case ft_msg:
-		case ft_bytes:
-		case ft_string:
-		case ft_cptr:
-			abort();
-			break;
-		case ft_unsigned:
-		case ft_int:
-		case ft_enum:
-		case ft_int8:
-		case ft_uint8:
-		case ft_int16:
-		case ft_uint16:
-		case ft_int32:
-		case ft_uint32:
-		case ft_int64:
-		case ft_uint64:
-			decodeVarint(G,f);
-			break;
-		case ft_signed:
-		case ft_sint8:
-		case ft_sint16:
-		case ft_sint32:
-		case ft_sint64:
-			decodeSVarint(G,f);
-			break;
-		case ft_bool:
-		case ft_fixed8:
-		case ft_sfixed8:
-			decode8bit(G,f);
-			break;
-		case ft_fixed16:
-		case ft_sfixed16:
-			decode16bit(G,f);
-			break;
-		case ft_fixed32:
-		case ft_sfixed32:
-		case ft_float:
-			decode32bit(G,f);
-			break;
-		case ft_fixed64:
-		case ft_sfixed64:
-		case ft_double:
-			decode64bit(G,f);
-			break;
+			"varint_t v = ud.u64;\n";
+		if (hasBulkPackedDecode(f)) {
+			decodePackedFixed(G,f);
+		} else {
+			G <<	"const uint8_t *ae = a + v;\n";
+			if (hasPackedVarint(f))
+				decodePackedCount(G,f);
+			G <<	"do {\n";
+			switch (type) {
+			default:
+			case ft_msg:
+			case ft_bytes:
+			case ft_string:
+			case ft_cptr:
+				abort();
+				break;
+			case ft_unsigned:
+			case ft_int:
+			case ft_enum:
+			case ft_int8:
+			case ft_uint8:
+			case ft_int16:
+			case ft_uint16:
+			case ft_int32:
+			case ft_uint32:
+			case ft_int64:
+			case ft_uint64:
+				decodeVarint(G,f);
+				break;
+			case ft_signed:
+			case ft_sint8:
+			case ft_sint16:
+			case ft_sint32:
+			case ft_sint64:
+				decodeSVarint(G,f);
+				break;
+			case ft_bool:
+			case ft_fixed8:
+			case ft_sfixed8:
+				decode8bit(G,f);
+				break;
+			case ft_fixed16:
+			case ft_sfixed16:
+				decode16bit(G,f);
+				break;
+			case ft_fixed32:
+			case ft_sfixed32:
+			case ft_float:
+				decode32bit(G,f);
+				break;
+			case ft_fixed64:
+			case ft_sfixed64:
+			case ft_double:
+				decode64bit(G,f);
+				break;
+			}
+			G <<	"} while (a < ae);\n";
 		}
-		G <<	"} while (a < ae);\n"
-			"break;\n"
+		G <<	"break;\n"
 			"}\n";
-		uint32_t enc = f->getEncoding();
+		// unpacked elements are also accepted
+		uint32_t enc = f->getElementEncoding();
 		if (enc == wt_lenpfx) {
 			G.setField(0);
 			return;
@@ -4836,13 +7910,29 @@ void CppGenerator::writeFromMemory_early(Generator &G, Field *f)
 		G <<	"case $(field_tag):\t// $(fname) id $(field_id), type $typestr, coding byte[]\n";
 		if (f->getQuantifier() == q_repeated)
 			G << "$(m_field).emplace_back();\n";
-		G <<	"if (((ssize_t)ud.vi > 0) && ((ssize_t)ud.vi <= (e-a))) {\n"
-			"int n;\n";
-		G.fillField("(const uint8_t*)a,ud.vi");
-		G <<	"if (n != (ssize_t)ud.vi)\n"
-			"	$handle_error;\n"
-			"a += ud.vi;\n"
-			"}\n";
+		if (f->isLazy()) {
+			G <<	"if (((ssize_t)ud.vi > 0) && ((ssize_t)ud.vi <= (e-a))) {\n"
+				"if (lazy_$(fname) || lazyused_$(fname)) {\n"
+				"lazy_decode_$(fname)();\n"
+				"int n = m_$(fname).$(fromMemory)((const uint8_t*)a,ud.vi);\n"
+				"if (n != (ssize_t)ud.vi)\n"
+				"	$handle_error;\n"
+				"} else {\n";
+			writeLazyFraming(G,"ud.vi");
+			G <<	"lazy_$(fname) = a;\n"
+				"lazysize_$(fname) = ud.vi;\n"
+				"}\n"
+				"a += ud.vi;\n"
+				"}\n";
+		} else {
+			G <<	"if (((ssize_t)ud.vi > 0) && ((ssize_t)ud.vi <= (e-a))) {\n"
+				"int n;\n";
+			G.fillField("(const uint8_t*)a,ud.vi");
+			G <<	"if (n != (ssize_t)ud.vi)\n"
+				"	$handle_error;\n"
+				"a += ud.vi;\n"
+				"}\n";
+		}
 		if (vbit != -1)
 			writeSetValid(G,vbit);
 		break;
@@ -4948,10 +8038,8 @@ void CppGenerator::writeFromMemory_early(Generator &G, Message *m)
 		G << "std::cout << \"$(msg_fullname)::$(fromMemory)(\" << (void*)b << \", \" << s << \")\\n\";\n";
 	G <<	"while (a < e) {\n"
 		"varint_t fid;\n";
-	const string &Terminator = target->getOption("Terminator");
-	if ((Terminator == "ff") || (Terminator == "0xff"))
-		G <<	"if (*a == 0xff)\t// 0xff terminator\n"
-			"break;\n";
+	int term = terminatorByte();
+	writeTerminatorCheck(G);
 	G <<	"union decode_union ud;\n"
 		"ssize_t x = decode_early(a,e,&ud,&fid);\n"
 		"if (x < 0)\n"
@@ -4993,12 +8081,8 @@ void CppGenerator::writeFromMemory_early(Generator &G, Message *m)
 			G.setField(0);
 		}
 	}
-	if ((Terminator == "null") || (Terminator == "0")) {
-		if (hasNullId) 
-			error("request to handle null termination, but null-tag exists");
-		G <<	"case 0:\t// terminate on null byte\n"
-			"	break;\n";
-	}
+	if ((term == 0) && hasNullId)
+		error("request to handle null termination, but null-tag exists");
 	G <<	"default:\n";
 	if (target->getOption("UnknownField") == "assert") {
 		G << "assert(0);	// unknown field (option unknwon=assert)\n";
@@ -5013,7 +8097,7 @@ void CppGenerator::writeFromMemory_early(Generator &G, Message *m)
 		fatal("unable to handle option unknown with value %s",target->getOption("UnknownField").c_str());
 	G <<	"}\n"
 		"}\n";
-	if (Asserts)
+	if (Asserts && (term < 0))
 		G << "assert((a-(const uint8_t *)b) == s);\n";
 	G <<	"if (a > e)\n"
 		"	$handle_error;\n"
@@ -32,6 +32,10 @@ class Options;
 class PBFile;
 class KVPair;
 
+// output of the block-wise serializers toMemoryUnchecked, toWire with
+// wirewrite, and toIovec
+typedef enum { blk_memory, blk_wire, blk_iovec } blksink_t;
+
 class CppGenerator : public CodeGeneratorImpl
 {
 	public:
@@ -71,10 +75,15 @@ class CppGenerator : public CodeGeneratorImpl
 	void writeCmp(Generator &G, Message *m);
 	void writeConstructor(Generator &G, Message *m);
 	void writeEqual(Generator &G, Message *m);
+	void writeFromJson(Generator &out, Field *f, bool rep);
+	void writeFromJson(Generator &out, Message *m);
 	void writeFromMemory_early(Generator &out, Field *f);
 	void writeFromMemory_early(Generator &out, Message *m);
 	void writeFromMemory(Generator &out, Field *f);
 	void writeFromMemory(Generator &out, Message *m);
+	void writeFromMemoryFixed(Generator &out, Message *m);
+	void writeFromMemoryMask(Generator &out, Message *m);
+	void writeMergeFromMemory(Generator &out, Message *m);
 	void writeFunctions(Generator &G, Message *m);
 	void writeFunctions(Generator &out, Field *f);
 	void writeGet(Generator &out, Field *f);
@@ -83,9 +92,15 @@ class CppGenerator : public CodeGeneratorImpl
 	void writeHeaderDecls(Generator &, Field *);
 	void writeInlines(Generator &out, Field *f);
 	void writeInlines(Generator &out, Message *m);
+	void writeLazyAccess(Generator &out, Message *m, const char *obj);
+	void writeLazyDecode(Generator &out, Field *f);
 	void writeMaxSize(Generator &, Message *m);
 	void writeMembers(Generator &G, Message *m, uint8_t stage);
 	void writeMutable(Generator &out, Field *f);
+	void writeMsgSizeToX(Generator &out, const char *size);
+	void writeParser(Generator &out, Message *m);
+	void writeValidate(Generator &G, Field *f);
+	void writeValidate(Generator &G, Message *m);
 	void writePrint(Generator &out, Field *f);
 	void writePrint(Generator &out, Message *m);
 	void writeReaders(Generator &G, optmode_t optmode);
@@ -93,27 +108,67 @@ class CppGenerator : public CodeGeneratorImpl
 	void writeSet(Generator &out, Field *f);
 	void writeSetByNameR(Generator &G, Field *f);
 	void writeSetByName(Generator &G, Message *m);
+	void writeSetByNameDispatch(Generator &G, const std::vector<Field *> &fields, size_t len);
+	void writeSetByNameF(Generator &G, Field *f);
 	void writeSize(Generator &, Field *f);
 	void writeStaticMember(Generator &G, Field *f, const char *n);
 	void writeStaticMembers(Generator &G, Message *m);
+	void writeTagPrediction(Generator &G, Message *m);
 	void writeTagToMemory(Generator &out, Field *f, unsigned = 0);
 	void writeTagToX(Generator &out, Field *f);
 	void writeToJson(Generator &out, Field *f, char fsep);
 	void writeToJson(Generator &out, Message *m);
+	void writeToJsonBuffer(Generator &out, Field *f, char fsep);
+	void writeToJsonBuffer(Generator &out, Message *m);
+	void writeCalcJsonSize(Generator &out, Message *m);
+	void writeMaxJsonSize(Generator &out, Message *m);
 	void writeToMemory(Generator &out, Field *f);
 	void writeToMemory(Generator &out, Message *m);
+	void writeTagToMemoryReverse(Generator &out, Field *f);
+	void writeValueToMemoryReverse(Generator &out, Field *f);
+	void writeToMemoryReverse(Generator &out, Field *f);
+	void writeToMemoryReverse(Generator &out, Message *m);
+	void writeTagToMemoryUnchecked(Generator &out, Field *f);
+	void writeValueToMemoryUnchecked(Generator &out, Field *f);
+	void writeToMemoryDelta(Generator &out, Message *m);
+	void writeToMemoryFixed(Generator &out, Message *m);
+	void writeToMemoryUnchecked(Generator &out, Message *m);
+	void writeToString(Generator &out, Message *m);
+	void writeBlockCommit(Generator &out, blksink_t s);
+	void writeBlockData(Generator &out, blksink_t s, const char *data, const char *size, bool mayBeEmpty = false);
+	void writeBlockMsgSize(Generator &out, const char *size);
+	void writeBlockReserve(Generator &out, blksink_t s, unsigned n);
+	void writeBlockTerminator(Generator &out, blksink_t s);
+	void writeValueToBlock(Generator &out, blksink_t s, Field *f);
+	void writeToBlock(Generator &out, blksink_t s, Field *f);
+	void writeWireFlush(Generator &out);
+	void writeToIovec(Generator &out, Message *m);
+	void writeToWireBlock(Generator &out, Message *m);
 	void writeToX(Generator &out, Field *f);
 	void writeToX(Generator &out, Message *m);
 	void writeUnequal(Generator &G, Message *m);
 
 	std::string getValid(Field *f, bool invalid = false);
+	bool toMemoryUsesN(Message *m);
+	int terminatorByte();
+	void writeTerminator(Generator &out, const char *check, const char *store);
+	void writeTerminatorCheck(Generator &out);
+	bool useFixedLayout(Message *m);
+	bool presizeToString();
 	const char *setValid(int vbit, unsigned numvalid);
+	std::string setDirty(Field *f);
+	std::string setDirtyIf(Field *f, const char *cond);
 	const char *clearValid(int vbit, unsigned numvalid);
 	void writeGetValid(Generator &out, Field *,bool = false);
 	void writeSetValid(Generator &out, int vbit);
 	void writeClearValid(Generator &out, int vbit);
 
 	void decodeByteArray(Generator &G, Field *f);
+	void decodeField(Generator &G, Field *f);
+	void decodeLazy(Generator &G, Field *f);
+	void decodePacked(Generator &G, Field *f);
+	void decodePackedFixed(Generator &G, Field *f);
+	void decodePackedCount(Generator &G, Field *f);
 	void decodeMessage(Generator &G, Field *f);
 	void decodeSVarint(Generator &G, Field *f);
 	void decodeVarint(Generator &G, Field *f);
@@ -127,15 +182,15 @@ class CppGenerator : public CodeGeneratorImpl
 	Options *clOptions;	// command line options to override target settings
 	optmode_t optmode;
 	endian_t Endian;
-	bool usesArrays, usesVectors, usesStringTypes, usesBytes,
-	     Asserts, Debug, PrintOut, SubClasses, Checks, PaddedMsgSize, SinkToTemplate,
-	     WithComments, WithJson, EarlyDecode,
+	bool usesArrays, usesVectors, usesStringTypes, usesBytes, usesViews,
+	     Asserts, Debug, PrintOut, SubClasses, Checks, PaddedMsgSize, CachedSize, SinkToTemplate,
+	     WithComments, WithJson, WithFieldMask, WithParser, WithDelta, WithMerge, EarlyDecode, TagPrediction,
 	     inlineClear, inlineHas, inlineGet, inlineMaxSize, inlineSet, inlineSize,
 	     hasVarInt, hasVarSInt, hasInt, hasSInt, hasUInt, hasCStr,
 	     hasBool, hasFloat, hasFloats, hasDouble, hasDoubles,
 	     hasS8, hasS16, hasS32, hasS64, hasU8, hasU16, hasU32, hasU64,
 	     hasWT8, hasWT16, hasWT32, hasWT64, hasEnums,
-	     hasBytes, hasString, hasLenPfx, hasRBytes, hasRString, hasUnused,
+	     hasBytes, hasString, hasLenPfx, hasRBytes, hasRString, hasUnused, hasLazy,
 	     needJsonString, needCalcSize, needSendVarSInt;
 	unsigned VarIntBits, WireputArg;
 	std::string ErrorHandling, license;
@@ -48,8 +48,10 @@ Field::Field(const char *n, unsigned l, quant_t q, uint32_t t, long long i)
 , intsize(64)
 , valid_bit(-3)
 , quan(q)
+, lazy(-1)
 , packed(false)
 , used(true)
+, mergeappend(false)
 , usage(use_regular)
 , storage(mem_unset)
 {
@@ -218,6 +220,26 @@ int64_t Field::getMaxSize() const
 		case ft_sint64:
 			ms = 10;
 			break;
+		// packed fixed size types
+		case ft_bool:
+		case ft_fixed8:
+		case ft_sfixed8:
+			ms = 1;
+			break;
+		case ft_fixed16:
+		case ft_sfixed16:
+			ms = 2;
+			break;
+		case ft_fixed32:
+		case ft_sfixed32:
+		case ft_float:
+			ms = 4;
+			break;
+		case ft_fixed64:
+		case ft_sfixed64:
+		case ft_double:
+			ms = 8;
+			break;
 		default:
 			abort();
 		}
@@ -688,6 +710,16 @@ bool Field::isVirtual() const
 }
 
 
+bool Field::isLazy() const
+{
+	if (((type & ft_filter) != ft_msg) || (quan == q_repeated) || (getStorage() != mem_regular))
+		return false;
+	if (lazy < 0)
+		return parent->isLazy();
+	return lazy;
+}
+
+
 bool Field::isMessage() const
 {
 	return ((type & ft_filter) == ft_msg);
@@ -1126,6 +1158,24 @@ void Field::setOption(const string &option, const string &value)
 			packed = false;
 		else
 			error("invalid value '%s' for option packed",value.c_str());
+	} else if (option == "lazy") {
+		if (((type & ft_filter) != ft_msg) || (quan == q_repeated))
+			error("option lazy is only supported for non-repeated message fields");
+		if (value == "true")
+			lazy = 1;
+		else if (value == "false")
+			lazy = 0;
+		else
+			error("invalid value '%s' for option lazy",value.c_str());
+	} else if (option == "merge") {
+		if (quan != q_repeated)
+			error("option merge is only supported for repeated fields");
+		if (value == "append")
+			mergeappend = true;
+		else if (value == "replace")
+			mergeappend = false;
+		else
+			error("invalid value '%s' for option merge",value.c_str());
 	} else if (option == "used") {
 		if (value == "true")
 			used = true;
@@ -172,6 +172,7 @@ class Field
 	void addOptions(class KVPair *);
 	void setOption(const std::string &option, const std::string &value);
 	bool isPacked() const;
+	bool isLazy() const;
 	unsigned getArraySize() const;
 	void setParent(Message *m);
 	void setTarget(Options *o = 0);
@@ -208,6 +209,9 @@ class Field
 	bool isDeprecated() const
 	{ return usage == use_deprecated; }
 
+	bool mergeAppends() const
+	{ return mergeappend; }
+
 	bool hasCustomStringtype() const
 	{ return stringtype != st_std; }
 
@@ -231,7 +235,8 @@ class Field
 	// >=0: bit0, ...
 	int valid_bit;
 	quant_t quan;
-	bool packed,used;
+	int8_t lazy;	// -1: inherit from message
+	bool packed,used,mergeappend;
 	usage_t usage;
 	mem_inst_t storage;
 };
@@ -108,15 +108,29 @@ Generator::Generator(ostream &str, const Options *o)
 	addVariable("ssize_t",o->getIdentifier("ssize_t"));
 	addVariable("BaseClass",o->getIdentifier("BaseClass"));
 	addVariable("toMemory",o->getIdentifier("toMemory"));
+	addVariable("toMemoryReverse",o->getIdentifier("toMemoryReverse"));
+	addVariable("toMemoryUnchecked",o->getIdentifier("toMemoryUnchecked"));
+	addVariable("toMemoryDelta",o->getIdentifier("toMemoryDelta"));
+	addVariable("markClean",o->getIdentifier("markClean"));
+	addVariable("toIovec",o->getIdentifier("toIovec"));
 	addVariable("toSink",o->getIdentifier("toSink"));
 	addVariable("toString",o->getIdentifier("toString"));
 	addVariable("toWire",o->getIdentifier("toWire"));
 	addVariable("toASCII",o->getIdentifier("toASCII"));
 	addVariable("toJSON",o->getIdentifier("toJSON"));
+	addVariable("fromJSON",o->getIdentifier("fromJSON"));
+	addVariable("toJSONBuffer",o->getIdentifier("toJSONBuffer"));
+	addVariable("calcJSONSize",o->getIdentifier("calcJSONSize"));
+	addVariable("maxJSONSize",o->getIdentifier("maxJSONSize"));
 	addVariable("fromMemory",o->getIdentifier("fromMemory"));
+	addVariable("mergeFromMemory",o->getIdentifier("mergeFromMemory"));
+	addVariable("prepareMerge",o->getIdentifier("prepareMerge"));
+	addVariable("parser",o->getIdentifier("Parser"));
+	addVariable("validate",o->getIdentifier("validate"));
 	addVariable("calcSize",o->getIdentifier("calcSize"));
 	addVariable("getMaxSize",o->getIdentifier("getMaxSize"));
 	addVariable("wireput","");
+	addVariable("wirewrite",o->getIdentifier("wirewrite"));
 	addVariable("putarg","");
 	addVariable("putparam","");
 	addVariable("write_varint","");
@@ -166,6 +180,9 @@ void Generator::setMode(genmode_t g)
 		setVariable("u64_wire","send_u64(put,$1)");
 		setVariable("write_bytes","put.append((const char *)$1,$2)");
 		setVariable("toX",getVariable("toString"));
+	} else if (m_options->isId("wirewrite")) {
+		// block-wise transmission via a staging buffer, toWire takes no argument
+		setVariable("putparam","");
 	} else if (toIdentifier(wireput)) {
 		setVariable("wireput",wireput);	// explicit function given to call
 		setVariable("putarg","");
@@ -510,7 +527,12 @@ void Generator::setField(const Field *f)
 		} else {
 			addVariable("field_value","m_"+fname);
 		}
-		addVariable("field_values",v ? "$(field_get)().data()" : "m_$(fname).data()");
+		if (v)
+			addVariable("field_values","$(field_get)().data()");
+		else if (f->getArraySize())	// array<> has no data()
+			addVariable("field_values","m_$(fname).begin()");
+		else
+			addVariable("field_values","m_$(fname).data()");
 
 		char tmp[64];
 		unsigned id = f->getId();
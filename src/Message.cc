@@ -43,6 +43,7 @@ Message::Message(const char *n, unsigned l, bool o)
 , m_numvalid(0)
 , m_used(false)
 , m_generate(false)
+, m_lazy(false)
 , m_storage(mem_regular)
 , m_sorting(sort_unset)
 {
@@ -203,6 +204,13 @@ void Message::setOption(const char *option, const char *value)
 			m_generate = false;
 		else
 			error("invalid argument %s for message option 'used'",value);
+	} else if (!strcmp(option,"lazy")) {
+		if (!strcmp(value,"true"))
+			m_lazy = true;
+		else if (!strcmp(value,"false"))
+			m_lazy = false;
+		else
+			error("invalid argument %s for message option 'lazy'",value);
 	} else {
 		error("invalid message option '%s'",option);
 	}
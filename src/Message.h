@@ -46,6 +46,7 @@ class Message
 	, m_numvalid(0)
 	, m_used(false)
 	, m_generate(false)
+	, m_lazy(false)
 	, m_storage(mem_regular)
 	, m_sorting(sort_unset)
 	{ }
@@ -141,6 +142,9 @@ class Message
 	mem_inst_t getStorage() const
 	{ return m_storage; }
 
+	bool isLazy() const
+	{ return m_lazy; }
+
 	std::string findROstring() const;
 
 	void setNumValid(unsigned n);
@@ -162,6 +166,7 @@ class Message
 	std::vector<unsigned> m_fieldseq;
 	std::vector< std::pair<unsigned,unsigned> > m_reservations;
 	bool m_used, m_generate;	// m_used is calculated by dependencies, m_generate is option/command-line setting
+	bool m_lazy;
 	mem_inst_t m_storage;
 	msg_sorting_t m_sorting;
 };
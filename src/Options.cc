@@ -49,6 +49,9 @@ static bool init_module()
 	BinOptionList["gnux"] = "allow GNU extensions in generated code";
 	BinOptionList["id0"] = "allow use of field ID 0";
 	BinOptionList["enumnames"] = "allow use of enum names in setByName functions";
+	BinOptionList["TagPrediction"] = "check for tag of next field in expected order before decoding generically";
+	BinOptionList["FieldMask"] = "generate fromMemory variant that decodes only fields selected by a FieldMask";
+	BinOptionList["CachedSize"] = "cache size of messages in calcSize for serializing embedded messages";
 
 	TextOptionList["author"] = "author of source file";
 	TextOptionList["copyright"] = "year of copyright of source file";
@@ -58,8 +61,8 @@ static bool init_module()
 	BinOptionList["withEqual"] = "generate operator == for object comparison";
 	BinOptionList["withUnequal"] = "generate operator != for object comparison";
 	TextOptionList["endian"] = "target endian to use (unknown,little,big)";
-	TextOptionList["stringtype"] = "implementation type for 'string': std::string (default), C (const char *), <typename>";
-	TextOptionList["bytestype"] = "implementation type for 'bytes': std::string (default), <typename>";
+	TextOptionList["stringtype"] = "implementation type for 'string': std::string (default), C (const char *), view (BufView), <typename>";
+	TextOptionList["bytestype"] = "implementation type for 'bytes': std::string (default), view (BufView), <typename>";
 	TextOptionList["arraysize"] = "use array of size <arraysize> instead of vector for repeated fields";
 	TextOptionList["UnknownField"] = "skip/assert unknown fields while parsing (default: skip)";
 	TextOptionList["namespace"] = "namespace of generated code (default: <none>)";
@@ -67,10 +70,18 @@ static bool init_module()
 	TextOptionList["codelib"] = "add code library file or directory";
 
 	TextOptionList["toMemory"] = "name of function for serializing to memory; \"\" to omit generation";
+	TextOptionList["toMemoryUnchecked"] = "name of function for serializing to memory without bounds checks; \"\" to omit generation";
+	TextOptionList["toMemoryReverse"] = "name of function for serializing to the end of memory back to front; \"\" to omit generation";
+	TextOptionList["toMemoryDelta"] = "name of function for serializing the fields changed since the last markClean; \"\" to omit generation";
+	TextOptionList["markClean"] = "name of function for resetting the modification state used by toMemoryDelta";
+	TextOptionList["toIovec"] = "name of function for serializing to an iovec array without copying large payloads; \"\" to omit generation";
 	TextOptionList["toString"] = "name of function for serializing to std::string; \"\" to omit generation";
 	TextOptionList["toWire"] = "name of function for serializing via function 'wireput'; \"\" to omit generation";
 	TextOptionList["calcSize"] = "set name of function for calculating size on wire; \"\" to omit generation";
 	TextOptionList["fromMemory"] = "produce/omit code for parsing memory";
+	TextOptionList["mergeFromMemory"] = "name of function for merging serialized data into an existing object; \"\" to omit generation";
+	TextOptionList["prepareMerge"] = "name of function for clearing the fields replaced by mergeFromMemory";
+	TextOptionList["validate"] = "name of static function for checking serialized data without decoding it; \"\" to omit generation";
 	TextOptionList["AddPrefix"] = "prefix to use for add methods";
 	TextOptionList["ClearPrefix"] = "prefix to use for clear methods";
 	TextOptionList["ClearName"] = "name of clear methods";
@@ -79,6 +90,7 @@ static bool init_module()
 	TextOptionList["MutablePrefix"] = "prefix to use for mutable methods";
 	TextOptionList["SetPrefix"] = "prefix to use for set methods";
 	TextOptionList["toSink"] = "name of function for serializing with sink interface; \"\" to omit generation";
+	TextOptionList["Parser"] = "name of nested class for resumable parsing of data arriving in chunks; \"\" to omit generation";
 	TextOptionList["ascii_string"] = "function for printing strings in toASCII (default: ascii_string)";
 	TextOptionList["ascii_bool"] = "function for printing bytes in toASCII (default: ascii_bool)";
 	TextOptionList["ascii_bytes"] = "function for printing bytes in toASCII (default: ascii_bytes)";
@@ -98,6 +110,7 @@ static bool init_module()
 	TextOptionList["Optimize"] = "optimization target (review,speed,size)";
 	TextOptionList["Optimize_for"] = "alias for option 'Optimize' kept for compatibility reasons";
 	TextOptionList["wireput"] = "function for puting data on the wire";
+	TextOptionList["wirewrite"] = "function for puting blocks of data on the wire; replaces 'wireput' in 'toWire'";
 	TextOptionList["SortMembers"] = "sort member variables by: id (default), name, type, size, unsorted";
 	TextOptionList["ErrorHandling"] = "error handling concept: assert, cancel (default), throw";
 	TextOptionList["wiresize"] = "library function to use as 'wiresize' function";
@@ -107,6 +120,10 @@ static bool init_module()
 	TextOptionList["inline"] = "comma separated list of methods to inline: has, get, set";
 	TextOptionList["lang"] = "output language type: C++, XML";
 	TextOptionList["toJSON"] = "name of function for generating JSON output";
+	TextOptionList["fromJSON"] = "name of function for parsing JSON input; \"\" to omit generation";
+	TextOptionList["toJSONBuffer"] = "name of function for writing JSON output to a buffer; \"\" to omit generation";
+	TextOptionList["calcJSONSize"] = "name of function for calculating the buffer size needed by toJSONBuffer";
+	TextOptionList["maxJSONSize"] = "name of static function for the maximum buffer size needed by toJSONBuffer";
 	TextOptionList["json_indent"] = "statement for JSON indention";
 	/*
 	 * inline: all methods and helper functions are inline in the header
@@ -243,12 +260,26 @@ void Options::initDefaults()
 	m_TextOptions["ascii_numeric"] = "ascii_numeric";
 	m_TextOptions["ascii_indent"] = "ascii_indent";
 	m_TextOptions["toMemory"] = "toMemory";
+	m_TextOptions["toMemoryReverse"] = "";
+	m_TextOptions["toMemoryUnchecked"] = "";
+	m_TextOptions["toMemoryDelta"] = "";
+	m_TextOptions["markClean"] = "markClean";
+	m_TextOptions["toIovec"] = "";
 	m_TextOptions["toSink"] = "";
+	m_TextOptions["Parser"] = "";
 	m_TextOptions["toString"] = "toString";
 	m_TextOptions["toWire"] = "toWire";
 	m_TextOptions["toJSON"] = "toJSON";
+	m_TextOptions["fromJSON"] = "";
+	m_TextOptions["toJSONBuffer"] = "";
+	m_TextOptions["calcJSONSize"] = "calcJSONSize";
+	m_TextOptions["maxJSONSize"] = "maxJSONSize";
 	m_TextOptions["fromMemory"] = "fromMemory";
+	m_TextOptions["mergeFromMemory"] = "";
+	m_TextOptions["prepareMerge"] = "prepareMerge";
+	m_TextOptions["validate"] = "";
 	m_TextOptions["wireput"] = "";
+	m_TextOptions["wirewrite"] = "";
 	m_TextOptions["SortMembers"] = "id";
 	m_TextOptions["ErrorHandling"] = "cancel";
 	m_TextOptions["MutableType"] = "pointer";
@@ -315,6 +346,9 @@ void Options::initDefaults()
 	m_BinOptions["PaddedMessageSize"] = false;
 	m_BinOptions["enumnames"] = false;
 	m_BinOptions["padded_message_size"] = false;
+	m_BinOptions["TagPrediction"] = false;
+	m_BinOptions["FieldMask"] = false;
+	m_BinOptions["CachedSize"] = false;
 }
 
 
@@ -331,11 +365,13 @@ void Options::initFieldDefaults()
 	m_TextOptions["to_ascii"] = "";
 	m_TextOptions["to_json"] = "";
 	m_TextOptions["usage"] = "regular";
+	m_TextOptions["merge"] = "replace";
 	// TODO, valid values could be: default, fixed, variable, dynamic
 	//m_TextOptions["encoding"] = "default";
 
 	m_BinOptions["devel"] = false;
 	m_BinOptions["packed"] = false;
+	m_BinOptions["lazy"] = false;
 	m_BinOptions["used"] = true;
 }
 
@@ -451,6 +487,14 @@ void Options::printDefines(ostream &out) const
 		out << "#define SUBCLASSES 1\n";
 	if (isId("toMemory"))
 		out << "#define HAVE_TO_MEMORY 1\n";
+	if (isId("toMemoryReverse"))
+		out << "#define HAVE_TO_MEMORY_REVERSE 1\n";
+	if (isId("toMemoryUnchecked"))
+		out << "#define HAVE_TO_MEMORY_UNCHECKED 1\n";
+	if (isId("toMemoryDelta"))
+		out << "#define HAVE_TO_MEMORY_DELTA 1\n";
+	if (isId("toIovec"))
+		out << "#define HAVE_TO_IOVEC 1\n";
 	if (isId("toString"))
 		out << "#define HAVE_TO_STRING 1\n";
 	if (isId("toSink"))
@@ -461,8 +505,22 @@ void Options::printDefines(ostream &out) const
 		out << "#define HAVE_TO_ASCII 1\n";
 	if (isId("toJSON"))
 		out << "#define HAVE_TO_JSON 1\n";
+	if (isId("fromJSON"))
+		out << "#define HAVE_FROM_JSON 1\n";
+	if (isId("toJSONBuffer"))
+		out << "#define HAVE_TO_JSON_BUFFER 1\n";
 	if (isId("fromMemory"))
 		out << "#define HAVE_FROM_MEMORY 1\n";
+	if (isId("mergeFromMemory"))
+		out << "#define HAVE_MERGE_FROM_MEMORY 1\n";
+	if (isId("validate"))
+		out << "#define HAVE_VALIDATE 1\n";
+	if (isId("Parser"))
+		out << "#define HAVE_PARSER 1\n";
+	if (getFlag("FieldMask"))
+		out << "#define HAVE_FIELD_MASK 1\n";
+	if (getFlag("CachedSize"))
+		out << "#define HAVE_CACHED_SIZE 1\n";
 	if (getFlag("padded_message_size"))
 		out << "#define HAVE_PADDED_MESSAGE_SIZE 1\n";
 	const string &errh = getOption("ErrorHandling");
@@ -753,6 +811,11 @@ void Options::addOption(const char *option, const char *v, bool documented)
 			error("invalid argument for option header: %s",v);
 		return;
 	}
+	if ((0 == strcasecmp(option,"stringtype")) || (0 == strcasecmp(option,"bytestype"))) {
+		// zero-copy reference into the parsed buffer, see bufview.h
+		if (value == "view")
+			value = "BufView";
+	}
 	if (0 == strcasecmp(option,"Optimize")) {
 		if (value == "size")
 			m_TextOptions["Optimize"] = value;
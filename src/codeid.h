@@ -58,6 +58,8 @@ typedef enum {
 	ct_read_u32,
 	ct_read_u64,
 	ct_read_varint,
+	ct_rwrite_varint,	// write varint back to front
+	ct_rwrite_xvarint,	// write sign extended varint back to front
 	ct_send_bytes,
 	ct_send_msg,
 	ct_send_u16,
@@ -67,8 +69,11 @@ typedef enum {
 	ct_send_xvarint,	// sign extended varint for varintbits < 64
 	ct_sint_varint,
 	ct_skip_content,
+	ct_skip_fields,
 	ct_to_dblstr,
 	ct_to_decstr,
+	ct_uwrite_varint,	// write varint without bounds check
+	ct_uwrite_xvarint,	// write sign extended varint without bounds check
 	ct_varint_sint,		// convert varint to signed varint
 	ct_wiresize,
 	ct_wiresize_s,
@@ -80,6 +85,24 @@ typedef enum {
 	ct_write_xvarint,	// sign extended varint for varintbits < 64
 	ct_cstrless,
 	ct_encode_bytes,
+	ct_json_skip_ws,
+	ct_json_parse_string,
+	ct_json_unescape,
+	ct_json_assign_string,
+	ct_json_parse_int,
+	ct_json_parse_uint,
+	ct_json_parse_dbl,
+	ct_json_parse_bool,
+	ct_json_skip_value,
+	ct_grisu_digits,
+	ct_json_buf_decstr,
+	ct_json_buf_dblstr,
+	ct_json_buf_key,
+	ct_json_buf_escape,
+	ct_json_buf_string,
+	ct_json_buf_cstr,
+	ct_json_strsize,
+	ct_json_cstrsize,
 	ct_id_max,		// beginning of unassigned id range
 } codeid_t;
 
@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2017-2021, Thomas Maier-Komor
+ *
+ *  This source file belongs to Wire-Format-Compiler.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _APPENDSTRING_H
+#define _APPENDSTRING_H
+
+#include <string>
+
+// string type that can only be appended to, i.e. without resize and
+// operator []
+class AppendString
+{
+	public:
+	void push_back(char c)
+	{ str.push_back(c); }
+
+	void append(const char *s, size_t l)
+	{ str.append(s,l); }
+
+	const char *data() const
+	{ return str.data(); }
+
+	size_t size() const
+	{ return str.size(); }
+
+	private:
+	std::string str;
+};
+
+#endif
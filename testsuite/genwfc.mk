@@ -26,16 +26,24 @@ WFCSRCS = testcases/empty_elements.wfc testcases/enumtest.wfc testcases/validbit
 	  testcases/unused.wfc testcases/fixed_only.wfc testcases/novarint.wfc \
 	  testcases/packed.wfc testcases/virtual.wfc testcases/byname.wfc \
 	  testcases/inv_def.wfc testcases/arraycheck.wfc testcases/binformats.wfc \
-	  testcases/xint.wfc testcases/initest.wfc
+	  testcases/xint.wfc testcases/initest.wfc testcases/lazy.wfc \
+	  testcases/parser.wfc testcases/projection.wfc \
+	  testcases/validate.wfc testcases/cachedsize.wfc \
+	  testcases/fixlayout.wfc testcases/delta.wfc \
+	  testcases/merge.wfc testcases/jsonparse.wfc \
+	  testcases/jsonbuf.wfc testcases/appendstr.wfc \
+	  testcases/nullterm.wfc
 
 
-CXXSRCS	= $(WFCSRCS:testcases/%.wfc=$(ODIR)/%.cpp) $(ODIR)/referencev2.cpp
+CXXSRCS	= $(WFCSRCS:testcases/%.wfc=$(ODIR)/%.cpp) $(ODIR)/referencev2.cpp \
+	  $(ODIR)/refser.cpp
 
 $(ODIR)/%.cpp: testcases/%.wfc
 	"$(WFC)" $(WFCFLAGS) $< -o $(@:.cpp=)
 
 
-all: $(CXXSRCS) $(ODIR)/skip_s.cpp $(ODIR)/comp_v1.cpp $(ODIR)/comp_v2.cpp
+all: $(CXXSRCS) $(ODIR)/skip_s.cpp $(ODIR)/comp_v1.cpp $(ODIR)/comp_v2.cpp \
+	$(ODIR)/newer_n.cpp
 
 
 
@@ -51,6 +59,10 @@ $(ODIR)/skip_s.cpp: testcases/skip.wfc
 	"$(WFC)" $(WFCFLAGS) -tsender testcases/skip.wfc -o $(ODIR)/skip_s
 	"$(WFC)" $(WFCFLAGS) -treceiver testcases/skip.wfc -o $(ODIR)/skip_r
 
+$(ODIR)/newer_n.cpp: testcases/newer.wfc
+	"$(WFC)" $(WFCFLAGS) -tnewer testcases/newer.wfc -o $(ODIR)/newer_n
+	"$(WFC)" $(WFCFLAGS) -tolder testcases/newer.wfc -o $(ODIR)/newer_o
+
 $(ODIR)/comp_v1.cpp: testcases/compatibility.wfc
 	"$(WFC)" $(WFCFLAGS) -tV1 -o $(ODIR)/comp_v1 testcases/compatibility.wfc
 
@@ -60,6 +72,11 @@ $(ODIR)/comp_v2.cpp: testcases/compatibility.wfc
 $(ODIR)/referencev2.cpp: testcases/reference.wfc
 	"$(WFC)" $(WFCFLAGS) -trev2 -o $(ODIR)/referencev2 $^
 
+$(ODIR)/refser.cpp: testcases/reference.wfc
+	"$(WFC)" $(WFCFLAGS) -ftoMemoryReverse=toMemoryReverse \
+	  -ftoMemoryUnchecked=toMemoryUnchecked -ftoSink=toSink \
+	  -fwirewrite=wirewrite -ftoIovec=toIovec -o $(ODIR)/refser $^
+
 $(ODIR)/binformats.cpp: testcases/binformats.wfc
 	"$(WFC)" $(WFCFLAGS) -tpc -o $(ODIR)/binformats_pc $^
 	"$(WFC)" $(WFCFLAGS) -tesp8266 -o $(ODIR)/binformats_esp8266 $^
@@ -112,6 +112,37 @@ void fail(const char *msg, const Message *l, const Message *r = 0)
 	abort();
 }
 
+// Compare the output of an alternative serialization with toMemory and
+// check that it decodes to the same object. ser(out) must store the
+// serialized data in out. If the output may differ from toMemory (e.g.
+// unpadded message sizes), identical must be false.
+template <class Message, class Serializer>
+void cmptomem(const Message &tb, Serializer ser, bool identical = true)
+{
+	ssize_t s = tb.calcSize();
+	uint8_t *buf = (uint8_t *)malloc(s);
+	++NumToMem;
+	ssize_t m = tb.toMemory(buf,s);
+	if (m != s)
+		fail("toMemory",&tb);
+	std::string out;
+	ser(out);
+	if (identical && ((out.size() != (size_t)s) || memcmp(out.data(),buf,s))) {
+		printf("expected:\n");
+		hexdump(buf,s);
+		printf("got:\n");
+		hexdump((const uint8_t *)out.data(),out.size());
+		abort();
+	}
+	Message fw;
+	++NumFromMem;
+	m = fw.fromMemory(out.data(),out.size());
+	if ((m != (ssize_t)out.size()) || (tb != fw))
+		fail("cmptomem",&tb,&fw);
+	free(buf);
+}
+
+
 template <class Message>
 void runcheck(const Message &tb)
 {
@@ -203,7 +234,7 @@ void runcheck(const Message &tb)
 #endif
 
 	Wire.clear();
-#ifdef WIREPUT_FUNCTION
+#if defined WIREPUT_FUNCTION || defined WIREWRITE_FUNCTION
 	++NumToWire;
 	tb.toWire();
 #else
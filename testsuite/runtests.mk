@@ -80,6 +80,18 @@ $(ODIR)/stringtest: $(ODIR)/stringtest.o $(ODIR)/stringtypes.o $(WFCOBJS)
 $(ODIR)/recursion: $(ODIR)/rtest.o $(ODIR)/recursion.o $(WFCOBJS)
 	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
 
+$(ODIR)/lazytest: $(ODIR)/lazytest.o $(ODIR)/lazy.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/parsertest: $(ODIR)/parsertest.o $(ODIR)/parser.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/projtest: $(ODIR)/projtest.o $(ODIR)/projection.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/validatetest: $(ODIR)/validatetest.o $(ODIR)/validate.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
 $(ODIR)/json_hs: $(ODIR)/json_hs.o $(ODIR)/hostscope.o $(WFCOBJS)
 	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
 
@@ -89,6 +101,36 @@ $(ODIR)/lt1: $(ODIR)/libtest1.o $(ODIR)/lt1.o $(WFCOBJS)
 $(ODIR)/skiptest: $(ODIR)/skiptest.o $(ODIR)/skip_s.o $(ODIR)/skip_r.o $(WFCOBJS)
 	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
 
+$(ODIR)/newertest: $(ODIR)/newertest.o $(ODIR)/newer_n.o $(ODIR)/newer_o.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/cachedsizetest: $(ODIR)/cachedsizetest.o $(ODIR)/cachedsize.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/serializetest: $(ODIR)/serializetest.o $(ODIR)/refser.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/fixlayouttest: $(ODIR)/fixlayouttest.o $(ODIR)/fixlayout.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/deltatest: $(ODIR)/deltatest.o $(ODIR)/delta.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/mergetest: $(ODIR)/mergetest.o $(ODIR)/merge.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/jsonparsetest: $(ODIR)/jsonparsetest.o $(ODIR)/jsonparse.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/jsonbuftest: $(ODIR)/jsonbuftest.o $(ODIR)/jsonbuf.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/appendstrtest: $(ODIR)/appendstrtest.o $(ODIR)/appendstr.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
+$(ODIR)/nulltermtest: $(ODIR)/nulltermtest.o $(ODIR)/nullterm.o $(WFCOBJS)
+	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
+
 $(ODIR)/reftest: $(ODIR)/reftest.o $(ODIR)/reference.o $(WFCOBJS)
 	$(CXX) $(CXXFLAGS) $^ -o $@ $(LIBS)
 
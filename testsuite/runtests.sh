@@ -23,7 +23,7 @@ MAKE=`which gmake||which make`
 SIZE=`which gsize||which size`
 #echo make is $MAKE
 
-declare -A flagsets cxxflags
+declare -A flagsets cxxflags testcases
 flagsets[fs_OsLs]='-Os -fwfclib=static -g'
 flagsets[fs_OsLi]='-Os -fwfclib=inline -g'
 flagsets[fs_OsLe]='-Os -fwfclib=extern -g'
@@ -35,6 +35,7 @@ flagsets[fs_OrLi]='-Or -fwfclib=inline -g'
 flagsets[fs_OrLe]='-Or -fwfclib=extern -g'
 flagsets[fs_O2s]='-O2 -s'
 flagsets[fs_O2sp]='-O2 -fpadded_message_size'
+flagsets[fs_O2tp]='-O2 -fTagPrediction'
 flagsets[fs_Ors]='-Or -s'
 flagsets[fs_Oss]='-Os -s'
 flagsets[fs_O2B]='-O2 -fwfclib=extern -fBaseClass="Message"'
@@ -63,6 +64,7 @@ cxxflags[fs_OrLs]="-Dstringtype=string"
 cxxflags[fs_OrLi]="-Dstringtype=string"
 cxxflags[fs_OrLe]="-Dstringtype=string"
 cxxflags[fs_O2s]="-Dstringtype=string"
+cxxflags[fs_O2tp]="-Dstringtype=string"
 cxxflags[fs_Ors]="-Dstringtype=string"
 cxxflags[fs_Oss]="-Dstringtype=string"
 cxxflags[fs_O2C]="-Dstringtype=string"
@@ -79,24 +81,31 @@ cxxflags[fs_O2le]="-Dstringtype=string"
 defaulttests="initests corruption enumtest empty_test tttest \
 	vbittest stringtest recursion json_hs lt1 skiptest reftest \
 	vbittest2 tttest fixed_test novi_test pack_test comp_test \
-	ref_byname byname_test inv_def_test arraycheck reftestv2"
+	ref_byname byname_test inv_def_test arraycheck reftestv2 lazytest \
+	parsertest projtest validatetest newertest cachedsizetest \
+	serializetest \
+	fixlayouttest deltatest mergetest jsonparsetest jsonbuftest \
+	nulltermtest"
 
 # tests that need special settings
-# TODO: cstrtest
+# TODO: cstrtest, xvarint
 extratests="cstrtest xvarint xint"
+# tests with their own stringtype, not supported by the extern library
+stringtests="appendstrtest"
 
-testcases[fs_OsLs]="$defaulttests xvarint xint"
-testcases[fs_OsLi]="$defaulttests xint"
+testcases[fs_OsLs]="$defaulttests $stringtests xint"
+testcases[fs_OsLi]="$defaulttests $stringtests xint"
 testcases[fs_OsLe]="$defaulttests"
-testcases[fs_O2Ls]="$defaulttests xvarint xint"
-testcases[fs_O2Li]="$defaulttests xint"
+testcases[fs_O2Ls]="$defaulttests $stringtests xint"
+testcases[fs_O2Li]="$defaulttests $stringtests xint"
 testcases[fs_O2Le]="$defaulttests"
-testcases[fs_OrLs]="$defaulttests xvarint xint"
-testcases[fs_OrLi]="$defaulttests xint"
+testcases[fs_OrLs]="$defaulttests $stringtests xint"
+testcases[fs_OrLi]="$defaulttests $stringtests xint"
 testcases[fs_OrLe]="$defaulttests"
-testcases[fs_O2s]="$defaulttests xint"
-testcases[fs_Ors]="$defaulttests xint"
-testcases[fs_Oss]="$defaulttests xint"
+testcases[fs_O2s]="$defaulttests $stringtests xint"
+testcases[fs_O2tp]="$defaulttests $stringtests xint"
+testcases[fs_Ors]="$defaulttests $stringtests xint"
+testcases[fs_Oss]="$defaulttests $stringtests xint"
 testcases[fs_O2C]="$defaulttests xint"
 testcases[fs_OsC]="$defaulttests xint"
 testcases[fs_OrC]="$defaulttests xint"
@@ -106,7 +115,7 @@ testcases[fs_OrA]="$defaulttests xint"
 testcases[fs_O2ALe]="$defaulttests"
 testcases[fs_OsALe]="$defaulttests"
 testcases[fs_OrALe]="$defaulttests"
-testcases[fs_O2le]="$defaulttests"
+testcases[fs_O2le]="$defaulttests $stringtests"
 
 
 CXXFLAGS0=$CXXFLAGS
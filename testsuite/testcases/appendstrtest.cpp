@@ -0,0 +1,40 @@
+#include "appendstr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+
+// toString must not need more than appending to the string
+static void check_string(const Sample &m)
+{
+	AppendString str;
+	str.append("prefix",6);
+	m.toString(str);
+	size_t s = m.calcSize();
+	uint8_t buf[s];
+	assert((ssize_t)s == m.toMemory(buf,s));
+	assert(str.size() == s+6);
+	assert(0 == memcmp(str.data(),"prefix",6));
+	assert(0 == memcmp(str.data()+6,buf,s));
+	Sample r;
+	assert((ssize_t)s == r.fromMemory(str.data()+6,s));
+	assert(r.id() == m.id());
+	assert(r.vals_size() == m.vals_size());
+}
+
+
+int main(int argc, char **argv)
+{
+	Sample m;
+	m.set_id(17);
+	check_string(m);
+	m.set_v(-123456789);
+	m.set_f(0xdeadbeef);
+	for (unsigned i = 0; i < 100; ++i)
+		m.add_vals(i*i);
+	m.mutable_sub()->set_x(300);
+	m.mutable_sub()->set_y(0x1234);
+	m.set_d(1.5);
+	check_string(m);
+	printf("%s: done\n",argv[0]);
+}
@@ -0,0 +1,78 @@
+#include "cachedsize.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+static void fill(Node *n, unsigned depth)
+{
+	char name[16];
+	sprintf(name,"depth%u",depth);
+	n->set_name(name);
+	n->mutable_leaf()->set_name("leaf");
+	for (unsigned i = 0; i < depth * 20; ++i)
+		n->mutable_leaf()->add_values(i * -1000);
+	if (depth == 0)
+		return;
+	n->add_leaves()->set_name(name);
+	fill(n->add_children(),depth-1);
+	fill(n->add_children(),depth-1);
+}
+
+
+static void check_cached(const Node &n)
+{
+	assert(n.cachedSize() == n.calcSize());
+	assert(n.leaf().cachedSize() == n.leaf().calcSize());
+	for (const Node &c : n.children())
+		check_cached(c);
+}
+
+
+int main(int argc, char **argv)
+{
+	Node n;
+	fill(&n,7);
+	runcheck(n);
+	check_cached(n);
+
+	// modification requires recalculation of the size
+	n.mutable_children(1)->mutable_children(0)->mutable_leaf()->set_name(string(200,'x').c_str());
+	size_t s = n.calcSize();
+	assert(n.cachedSize() == s);
+	check_cached(n);
+	uint8_t *buf = (uint8_t *) malloc(s);
+	ssize_t r = n.toMemory(buf,s);
+	assert(r == (ssize_t)s);
+	Node p;
+	r = p.fromMemory(buf,s);
+	assert(r == (ssize_t)s);
+	assert(p == n);
+	runcheck(n);
+
+	// a stale cached size must be reported
+	n.mutable_children(0)->mutable_leaf()->set_name("");
+#if defined HAVE_PADDED_MESSAGE_SIZE
+	// the padded size is placed after serialization
+#elif defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		n.toMemory(buf,s);
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(n.toMemory(buf,s) < 0);
+#endif
+	assert(n.calcSize() < s);
+	r = n.toMemory(buf,s);
+	assert(r == (ssize_t)n.cachedSize());
+	free(buf);
+	printf("%s: %s\n",argv[0],testcnt());
+}
@@ -0,0 +1,143 @@
+#include "delta.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+// send the changes of s to r and check that both are equal afterwards
+static ssize_t send_delta(Status &s, Status &r)
+{
+	uint8_t buf[1024];
+	ssize_t c = s.calcSize();
+	ssize_t n = s.toMemoryDelta(buf,sizeof(buf));
+	assert(n >= 0);
+	assert(n <= c);
+	++NumToMem;
+	s.markSent();
+	++NumFromMem;
+	ssize_t x = r.mergeFromMemory(buf,n);
+	assert(x == n);
+	assert(s == r);
+	return n;
+}
+
+
+int main(int argc, char **argv)
+{
+	Status s, r;
+	runcheck(s);
+
+	// nothing modified
+	assert(0 == send_delta(s,r));
+
+	s.set_seq(1);
+	s.set_state("starting");
+	s.set_temp(21.5);
+	s.set_offset(-3);
+	for (int i = 0; i < 4; ++i) {
+		Sample *x = s.add_samples();
+		x->set_channel(i);
+		x->set_value(i*-10);
+	}
+	s.add_errors(404);
+	s.add_errors(500);
+	s.mutable_last()->set_channel(9);
+	s.set_alarm(false);
+	s.add_hist(1);
+	s.add_hist(2);
+	s.set_uptime(123456789);
+	s.mutable_ref()->set_channel(3);
+	runcheck(s);
+	assert((ssize_t)s.calcSize() == send_delta(s,r));
+	assert(0 == send_delta(s,r));
+
+	// a single scalar
+	s.set_temp(22.0);
+	assert(9 == send_delta(s,r));
+
+	// repeated fields are replaced, not appended
+	s.mutable_samples(1)->set_value(77);
+	assert(send_delta(s,r) < (ssize_t)s.calcSize());
+	assert(r.samples_size() == 4);
+	s.clear_errors();
+	s.add_errors(200);
+	s.set_hist(0,10);
+	s.set_seq(2);
+	send_delta(s,r);
+	assert(r.errors_size() == 1);
+	assert(r.hist_size() == 2);
+
+	// embedded messages are replaced
+	s.mutable_last()->set_value(5);
+	s.mutable_ref()->set_value(-5);
+	s.set_state("running");
+	send_delta(s,r);
+	runcheck(s);
+
+	// failed setByName calls do not mark fields dirty
+#if defined ON_ERROR_THROW
+	try {
+		s.setByName("uptime","x");
+		abort();
+	} catch (int x) {
+		++NumErrThrow;
+		assert(x < 0);
+	}
+	try {
+		s.setByName("last.nosuch","1");
+		abort();
+	} catch (int x) {
+		++NumErrThrow;
+		assert(x < 0);
+	}
+#elif defined ON_ERROR_CANCEL
+	assert(0 > s.setByName("uptime","x"));
+	assert(0 > s.setByName("last.nosuch","1"));
+#endif
+	assert(0 == send_delta(s,r));
+	assert(0 < s.setByName("uptime","77"));
+	assert(0 < send_delta(s,r));
+	assert(r.uptime() == 77);
+	assert(0 < s.setByName("samples[2].value","8"));
+	assert(0 < send_delta(s,r));
+	assert(r.samples(2).value() == 8);
+
+	// values that fail to parse from JSON do not mark fields dirty
+	const char *bad = "{\"uptime\":\"x\"}";
+#if defined ON_ERROR_THROW
+	try {
+		s.fromJSON(bad,strlen(bad));
+		abort();
+	} catch (int x) {
+		++NumErrThrow;
+		assert(x < 0);
+	}
+#elif defined ON_ERROR_CANCEL
+	assert(0 > s.fromJSON(bad,strlen(bad)));
+#endif
+	assert(0 == send_delta(s,r));
+	const char *good = "{\"uptime\":78}";
+	assert((ssize_t)strlen(good) == s.fromJSON(good,strlen(good)));
+	assert(0 < send_delta(s,r));
+	assert(r.uptime() == 78);
+
+	// independent receivers see the same state
+	Status t;
+	uint8_t buf[1024];
+	s.calcSize();
+	ssize_t n = s.toMemory(buf,sizeof(buf));
+	assert(n > 0);
+	++NumFromMem;
+	assert(n == t.mergeFromMemory(buf,n));
+	assert(t == r);
+	// merging the same data again does not duplicate repeated fields
+	++NumFromMem;
+	assert(n == t.mergeFromMemory(buf,n));
+	assert(t == r);
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
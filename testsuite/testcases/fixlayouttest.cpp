@@ -0,0 +1,99 @@
+#include "fixlayout.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+static void check_position(const Position &p)
+{
+	runcheck(p);
+	uint8_t buf[64];
+	ssize_t n = p.toMemory(buf,sizeof(buf));
+	assert(n == (ssize_t)p.calcSize());
+	++NumToMem;
+	// too small buffers must be rejected
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		p.toMemory(buf,n-1);
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(p.toMemory(buf,n-1) < 0);
+#endif
+	Position q;
+	++NumFromMem;
+	assert(n == q.fromMemory(buf,n));
+	assert(p == q);
+}
+
+
+// fields in a different order must be decoded as well
+static void check_order(const Position &p)
+{
+	uint8_t buf[64], rev[64];
+	ssize_t n = p.toMemory(buf,sizeof(buf));
+	// move 'time' (tag and 4 bytes) to the end
+	memcpy(rev,buf+5,n-5);
+	memcpy(rev+n-5,buf,5);
+	Position q;
+	++NumFromMem;
+	assert(n == q.fromMemory(rev,n));
+	assert(p == q);
+}
+
+
+// a bool value beyond a single byte varint takes the generic decoder
+static void check_bool(const Position &p)
+{
+	uint8_t buf[64];
+	ssize_t n = p.toMemory(buf,sizeof(buf));
+	// 'fix' is stored after time, lat, lon, alt, course, and sats
+	assert(buf[33] == ((7 << 3) | 3));
+	buf[34] = 0x81;
+	Position q;
+	++NumFromMem;
+	assert(n == q.fromMemory(buf,n));
+	assert(q.fix());
+	assert(q.hdop() == p.hdop());
+}
+
+
+int main(int argc, char **argv)
+{
+	Position p;
+	check_position(p);
+
+	p.set_time(0x12345678);
+	p.set_lat(48.137154);
+	p.set_lon(-11.576124);
+	p.set_alt(519.5);
+	p.set_course(-1800);
+	p.set_sats(12);
+	p.set_fix(true);
+	p.set_seq(-0x123456789abcLL);
+	p.set_hdop(0xfedcba98);
+	check_position(p);
+	check_order(p);
+	check_bool(p);
+
+	Track t;
+	t.set_id(7);
+	runcheck(t);
+	for (int i = 0; i < 10; ++i) {
+		p.set_time(i*1000);
+		p.set_course(i*100);
+		p.set_fix(i&1);
+		*t.add_points() = p;
+	}
+	runcheck(t);
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
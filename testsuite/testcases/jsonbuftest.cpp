@@ -0,0 +1,146 @@
+#include "jsonbuf.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+template <class M>
+static string json_buffer(const M &m)
+{
+	size_t s = m.calcJSONSize();
+	char *buf = (char *) malloc(s);
+	ssize_t n = m.toJSONBuffer(buf,s);
+	assert(n > 0);
+	assert((size_t)n <= s);
+	string r(buf,n);
+	free(buf);
+	return r;
+}
+
+
+// output to the buffer must be identical to toJSON
+template <class M>
+static void json_compare(const M &m)
+{
+	stringstream ss;
+	m.toJSON(ss);
+	string b = json_buffer(m);
+	if (ss.str() != b) {
+		printf("toJSON:\n%s\ntoJSONBuffer:\n%s\n",ss.str().c_str(),b.c_str());
+		abort();
+	}
+	assert(b.size() <= M::maxJSONSize());
+
+	// buffer smaller than calcJSONSize, but large enough for the output
+	char buf[4096];
+	assert(b.size() < sizeof(buf));
+	ssize_t n = m.toJSONBuffer(buf,b.size());
+	assert(n == (ssize_t)b.size());
+	assert(0 == memcmp(buf,b.data(),n));
+
+	// buffer too small for the output
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		m.toJSONBuffer(buf,b.size()-1);
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(m.toJSONBuffer(buf,b.size()-1) < 0);
+#endif
+}
+
+
+int main(int argc, char **argv)
+{
+	Empty e;
+	json_compare(e);
+	assert(json_buffer(e) == "{\n}\n");
+
+	Point p;
+	json_compare(p);
+	p.set_x(INT32_MIN);
+	p.set_y(INT32_MIN);
+	p.set_mode(automatic);
+	p.set_visible(false);
+	p.set_f8(255);
+	json_compare(p);
+	assert(p.calcJSONSize() <= Point::maxJSONSize());
+	assert(p.calcJSONSize(3) <= Point::maxJSONSize(3));
+	p.set_mode((Mode)7);
+	json_compare(p);
+
+	Doc d;
+	json_compare(d);
+	assert(Doc::maxJSONSize() == SIZE_MAX);
+	d.set_id(UINT64_MAX);
+	json_compare(d);
+	d.set_name("quote\" backslash\\ tab\t newline\n");
+	d.set_data("\x01\x7f\x80\xff/");
+	d.mutable_origin()->set_x(-1);
+	d.mutable_origin()->set_mode(on);
+	d.add_points()->set_x(1);
+	d.add_points()->set_y(-2);
+	d.add_tags("a");
+	d.add_tags("");
+	d.add_tags("\"c\"");
+	d.add_nums(INT64_MIN);
+	d.add_nums(0);
+	d.add_nums(INT64_MAX);
+	d.add_modes(off);
+	d.add_modes(automatic);
+	d.set_i8(-128);
+	d.set_u16(65535);
+	d.add_flags(true);
+	d.add_flags(false);
+	json_compare(d);
+	runcheck(d);
+
+	// floating point values are always written in the shortest
+	// representation that reads back to the same value
+	Measure m;
+	m.set_value(0.1);
+	m.set_ratio(0.1f);
+	m.add_samples(1.0/3);
+	m.add_samples(-0.0);
+	m.add_samples(5e-324);
+	m.add_samples(1e21);
+	m.add_samples(-1.5e-7);
+	m.add_samples(123456789);
+	m.add_samples(NAN);
+	m.add_samples(-INFINITY);
+	string s = json_buffer(m);
+	const char *exp =
+		"{\n"
+		"  \"value\":0.1,\n"
+		"  \"ratio\":0.1,\n"
+		"  \"samples\":[\n"
+		"      0.3333333333333333,\n"
+		"      -0,\n"
+		"      5e-324,\n"
+		"      1e+21,\n"
+		"      -1.5e-07,\n"
+		"      123456789,\n"
+		"      \"NaN\",\n"
+		"      \"-Infinity\"\n"
+		"  ]\n"
+		"}\n";
+	if (s != exp) {
+		printf("%s",s.c_str());
+		abort();
+	}
+
+	printf("%s: %s\n",argv[0],testcnt());
+	return 0;
+}
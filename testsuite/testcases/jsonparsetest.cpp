@@ -0,0 +1,308 @@
+#include "jsonparse.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <locale.h>
+#include <sstream>
+#include <type_traits>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+// with StringType=C strings have no storage and are skipped by fromJSON
+static const bool ParseStrings = !is_pointer<decltype(All().name())>::value;
+
+
+static string json_buffer(const All &a)
+{
+	string s(a.calcJSONSize(),0);
+	ssize_t n = a.toJSONBuffer(&s[0],s.size());
+	assert(n > 0);
+	s.resize(n);
+	return s;
+}
+
+
+template <typename F>
+static bool same_bits(F x, F y)
+{
+	return 0 == memcmp(&x,&y,sizeof(F));
+}
+
+
+static void json_roundtrip(const All &a)
+{
+	stringstream ja;
+	a.toJSON(ja);
+	string s = ja.str();
+	All b;
+	ssize_t n = b.fromJSON(s.data(),s.size());
+	assert(n > 0);
+	assert((size_t)n <= s.size());
+	stringstream jb;
+	b.toJSON(jb);
+	if (ParseStrings && (ja.str() != jb.str())) {
+		printf("%s\n%s\n",ja.str().c_str(),jb.str().c_str());
+		abort();
+	}
+
+	// toJSON rounds floating point values unless optimizing for speed,
+	// toJSONBuffer always writes the shortest exact representation
+	s = json_buffer(a);
+	All c;
+	n = c.fromJSON(s.data(),s.size());
+	assert(n > 0);
+	assert((size_t)n <= s.size());
+	assert(same_bits(c.value(),a.value()));
+	assert(same_bits(c.ratio(),a.ratio()));
+	assert(c.samples_size() == a.samples_size());
+	for (size_t i = 0; i < a.samples_size(); ++i)
+		assert(same_bits(c.samples(i),a.samples(i)));
+}
+
+
+// JSON representation of a double
+static string json_double(double d)
+{
+	All a;
+	a.set_value(d);
+	string s = json_buffer(a);
+	size_t b = s.find("\"value\":");
+	assert(b != string::npos);
+	b += 8;
+	return s.substr(b,s.find_first_of(",\n",b)-b);
+}
+
+
+static void parse_error(const char *json)
+{
+	All a;
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		a.fromJSON(json,strlen(json));
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(a.fromJSON(json,strlen(json)) < 0);
+#endif
+}
+
+
+int main(int argc, char **argv)
+{
+	All a;
+	json_roundtrip(a);
+	a.set_id(7);
+	json_roundtrip(a);
+	a.set_i8(-100);
+	a.set_s16(-30000);
+	a.set_i64(-1234567890123LL);
+	a.set_u8(200);
+	a.set_f64(0xfedcba9876543210ULL);
+	a.set_flag(true);
+	a.set_ratio(0.25);
+	a.set_value(-1.5);
+	a.set_name("quote\" backslash\\ tab\t");
+	a.set_data("\x01\x1f\x7f");
+	a.set_color(blue);
+	a.mutable_sub()->set_x(-5);
+	a.mutable_sub()->set_label("sub");
+	a.add_subs()->set_x(1);
+	a.add_subs()->set_label("second");
+	a.add_tags("a");
+	a.add_tags("");
+	a.add_tags("c");
+	a.add_nums(-1);
+	a.add_nums(0);
+	a.add_nums(1000000);
+	a.add_colors(green);
+	a.add_colors(red);
+	a.add_bits(true);
+	a.add_bits(false);
+	a.add_samples(1e-3);
+	a.add_samples(42);
+	json_roundtrip(a);
+	runcheck(a);
+
+	// characters that need escaping at every offset of a long string
+	for (unsigned i = 0; i < 40; ++i) {
+		char s[41];
+		memset(s,'x',sizeof(s));
+		s[i] = "\"\\\n\x01\x7f\x1f/"[i % 7];
+		All c;
+		c.set_id(i);
+		c.set_data(s,sizeof(s));
+		c.set_name(s,sizeof(s)-1);
+		json_roundtrip(c);
+	}
+
+	// exact output of C string escapes and line wrapping, the size and
+	// speed variants of json_cstr and ascii_string must not differ
+	Sub e;
+	e.set_x(1);
+	e.set_label("\x01\x08\t\n\x0b\x0c\r\x1b\x1f \"\\/\x7f\x80\xff"
+		"0123456789012345678901234567890123456789012345678901234567890123456789\t");
+#ifdef HAVE_TO_JSON
+	stringstream ej;
+	e.toJSON(ej);
+	assert(ej.str() ==
+		"{\n"
+		"  \"x\":1,\n"
+		"  \"label\":\"\\u0001\\b\\t\\n\\u000b\\f\\r\\u001b\\u001f \\\"\\\\/\\u007f\\u0080\\u00ff"
+		"0123456789012345678901234567890123456789012345678901234567890123456789\\t\"\n"
+		"}\n");
+#endif
+#ifdef HAVE_TO_ASCII
+	stringstream ea;
+	e.toASCII(ea);
+	assert(ea.str() ==
+		"Sub {\n"
+		"\tx1;\n"
+		"\tlabel\"\\0001\\b\\t\\n\"\n"
+		"\n"
+		"\t\"\\v\\f\\r\\e\\0037 \\\"\\\\/\\0177\\0200\\0377012345678901234567890123456789012345678901234567\"\n"
+		"\n"
+		"\t\"8901234567890123456789\\t\";\n"
+		"}");
+#endif
+
+	// extreme, subnormal, and negative zero numbers
+	static const double dbls[] = { 0.1, 1.0/3, -0.0, 5e-324, 2.2250738585072014e-308,
+		1.7976931348623157e308, -1e21, 1e-7, 123456789.125 };
+	for (double d : dbls) {
+		All c;
+		c.set_value(d);
+		if (fabs(d) < 3e38)
+			c.set_ratio(d);
+		c.add_samples(d);
+		c.add_samples(-d);
+		c.set_i64(INT64_MIN);
+		c.set_f64(UINT64_MAX);
+		c.add_nums(INT32_MIN);
+		json_roundtrip(c);
+	}
+	assert(json_double(0.1) == "0.1");
+	assert(json_double(5e-324) == "5e-324");
+	assert(json_double(1e23) == "1e+23");
+	assert(json_double(DBL_MAX) == "1.7976931348623157e+308");
+
+	// hand written input: whitespace, unknown keys, escapes, enum names and numbers
+	const char *json =
+		" {\n"
+		"  \"id\" : 9,\n"
+		"  \"unknown\":{\"x\":[1,2,{\"y\":\"}]\"}],\"z\":null},\n"
+		"  \"name\":\"a\\\"b\\\\c\\/\\n\\u0041\\u20ac\",\n"
+		"  \"color\":\"green\",\n"
+		"  \"colors\":[2, \"red\" ,1],\n"
+		"  \"value\":1.5e3,\n"
+		"  \"ratio\":\"NaN\",\n"
+		"  \"i64\":-9223372036854775808,\n"
+		"  \"f64\":18446744073709551615,\n"
+		"  \"nums\":[],\n"
+		"  \"subs\":[{},{\"x\":3,\"more\":[true,false]}],\n"
+		"  \"sub\":{\"label\":\"\",\"x\":-7},\n"
+		"  \"flag\":false,\n"
+		"  \"tags\":[\"x\"]\n"
+		"} trailing";
+	All b;
+	b.add_nums(5);
+	ssize_t n = b.fromJSON(json,strlen(json));
+	assert(n == (ssize_t)(strlen(json) - strlen(" trailing")));
+	assert(b.id() == 9);
+	if (ParseStrings) {
+		assert(b.has_name());
+		assert(b.name() == "a\"b\\c/\nA\xe2\x82\xac");
+		assert(b.sub().label() == "");
+		assert(b.tags_size() == 1);
+		assert(b.tags(0) == "x");
+	}
+	assert(b.color() == green);
+	assert(b.colors_size() == 3);
+	assert(b.colors(0) == blue);
+	assert(b.colors(1) == red);
+	assert(b.colors(2) == green);
+	assert(b.value() == 1500);
+	assert(isnan(b.ratio()));
+	assert(b.i64() == INT64_MIN);
+	assert(b.f64() == UINT64_MAX);
+	assert(b.nums_size() == 0);
+	assert(b.subs_size() == 2);
+	assert(!b.subs(0).has_x());
+	assert(b.subs(1).x() == 3);
+	assert(b.sub().x() == -7);
+	assert(b.has_flag() && !b.flag());
+	assert(!b.has_i8());
+
+	// null clears a field, fields not present are left untouched
+	const char *update = "{\"flag\":null,\"colors\":null,\"i8\":-128}";
+	n = b.fromJSON(update,strlen(update));
+	assert(n == (ssize_t)strlen(update));
+	assert(!b.has_flag());
+	assert(b.colors_size() == 0);
+	assert(b.i8() == -128);
+	assert(b.id() == 9);
+	assert(b.subs_size() == 2);
+
+	// escaped keys are decoded before they are compared to the field names
+	const char *esckey = "{\"\\u0069d\":11,\"v\\u0061lue\":2.5,\"\\u0069d\\u0069d\":1}";
+	n = b.fromJSON(esckey,strlen(esckey));
+	assert(n == (ssize_t)strlen(esckey));
+	assert(b.id() == 11);
+	assert(b.value() == 2.5);
+
+	// unicode escapes are decoded to UTF-8, unpaired surrogates are rejected
+	const char *uni = "{\"name\":\"\\u00e9\\u20AC\\ud83d\\ude00\"}";
+	n = b.fromJSON(uni,strlen(uni));
+	assert(n == (ssize_t)strlen(uni));
+	if (ParseStrings) {
+		assert(b.name() == "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+		parse_error("{\"name\":\"\\ud83d\"}");
+		parse_error("{\"name\":\"\\ude00\\ud83d\"}");
+		parse_error("{\"tags\":[\"\\ud83d\\u0041\"]}");
+	}
+	parse_error("{\"\\udc00\":1}");
+
+	// the decimal point does not depend on the locale
+	if (setlocale(LC_NUMERIC,"de_DE.UTF-8") || setlocale(LC_NUMERIC,"de_DE")) {
+		const char *dbl = "{\"value\":0.125}";
+		n = b.fromJSON(dbl,strlen(dbl));
+		setlocale(LC_NUMERIC,"C");
+		assert(n == (ssize_t)strlen(dbl));
+		assert(b.value() == 0.125);
+	}
+
+	// numbers are parsed up to 63 characters
+	string num = "{\"value\":1." + string(61,'0') + "}";
+	n = b.fromJSON(num.data(),num.size());
+	assert(n == (ssize_t)num.size());
+	assert(b.value() == 1);
+	num = "{\"value\":1." + string(62,'0') + "}";
+	parse_error(num.c_str());
+
+	parse_error("");
+	parse_error("[]");
+	parse_error("{\"id\":1");
+	parse_error("{\"id\" 1}");
+	parse_error("{\"id\":1,}");
+	parse_error("{\"id\":-1}");
+	parse_error("{\"i8\":128}");
+	parse_error("{\"u8\":1.5}");
+	parse_error("{\"color\":\"purple\"}");
+	parse_error("{\"flag\":1}");
+	parse_error("{\"name\":\"\\x\"}");
+	parse_error("{\"nums\":[1,2}");
+	parse_error("{\"sub\":{\"x\":1}");
+	parse_error("{\"unknown\":[1,2}");
+
+	printf("%s: %s\n",argv[0],testcnt());
+	return 0;
+}
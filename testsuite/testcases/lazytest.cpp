@@ -0,0 +1,126 @@
+#include "lazy.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+int main(int argc, char **argv)
+{
+	Packet p;
+	p.mutable_header()->set_dest(7);
+	runcheck(p);
+
+	Payload *pl = p.mutable_payload();
+	pl->set_text("lazy payload");
+	pl->add_values(1);
+	pl->add_values(1000);
+	p.mutable_trailer()->set_text("trailer");
+	runcheck(p);
+
+	Forward f;
+	f.mutable_header()->set_dest(3);
+	f.mutable_header()->set_route("a.b.c");
+	*f.mutable_payload() = *pl;
+	f.set_hops(2);
+	runcheck(f);
+
+	// undecoded data must be forwarded verbatim
+	size_t s = f.calcSize();
+	uint8_t buf[s], fwd[s];
+	ssize_t n = f.toMemory(buf,s);
+	assert(n == (ssize_t)s);
+	Forward g;
+	n = g.fromMemory(buf,s);
+	assert(n == (ssize_t)s);
+	assert(g.calcSize() == s);
+	n = g.toMemory(fwd,s);
+	assert(n == (ssize_t)s);
+	assert(0 == memcmp(buf,fwd,s));
+
+	// first access decodes
+	assert(g.header().dest() == 3);
+	assert(g.payload().values(1) == 1000);
+	assert(g == f);
+
+	// modification after access is serialized
+	g.mutable_payload()->add_values(5);
+	uint8_t mod[g.calcSize()];
+	n = g.toMemory(mod,sizeof(mod));
+	assert(n == (ssize_t)sizeof(mod));
+	Forward h;
+	h.fromMemory(mod,n);
+	assert(h.payload().values_size() == 3);
+	h.clear_payload();
+	assert(!h.has_payload());
+	runcheck(h);
+
+	// repeated occurrences of a lazy field are merged
+	Forward f1, f2;
+	f1.mutable_header()->set_dest(1);
+	f1.mutable_payload()->set_text("first");
+	f1.mutable_payload()->add_values(10);
+	f2.mutable_header()->set_dest(2);
+	f2.mutable_header()->set_route("r");
+	f2.mutable_payload()->add_values(20);
+	size_t s1 = f1.calcSize(), s2 = f2.calcSize();
+	uint8_t two[s1+s2];
+	assert(f1.toMemory(two,s1) == (ssize_t)s1);
+	assert(f2.toMemory(two+s1,s2) == (ssize_t)s2);
+	Forward m;
+	assert(m.fromMemory(two,s1+s2) == (ssize_t)(s1+s2));
+	uint8_t merged[m.calcSize()];
+	n = m.toMemory(merged,sizeof(merged));
+	assert(n == (ssize_t)sizeof(merged));
+	Forward r;
+	assert(r.fromMemory(merged,n) == n);
+	assert(r.header().dest() == 2);
+	assert(r.header().route() == "r");
+	assert(r.payload().text() == "first");
+	assert(r.payload().values_size() == 2);
+	assert(r.payload().values(0) == 10);
+	assert(r.payload().values(1) == 20);
+	runcheck(r);
+
+	// data present before fromMemory is merged with the parsed data
+	Packet q;
+	q.mutable_payload()->add_values(3);
+	uint8_t pb[p.calcSize()];
+	n = p.toMemory(pb,sizeof(pb));
+	assert(n == (ssize_t)sizeof(pb));
+	assert(q.fromMemory(pb,n) == n);
+	uint8_t qb[q.calcSize()];
+	n = q.toMemory(qb,sizeof(qb));
+	assert(n == (ssize_t)sizeof(qb));
+	Packet t;
+	assert(t.fromMemory(qb,n) == n);
+	assert(t.payload().text() == "lazy payload");
+	assert(t.payload().values_size() == 3);
+	assert(t.payload().values(0) == 3);
+	assert(t.payload().values(2) == 1000);
+	runcheck(t);
+
+	// malformed framing of a lazy field is rejected when it is recorded
+	uint8_t bad[] = {
+		0x0a, 0x02, 0x08, 0x01,		// header.dest = 1
+		0x12, 0x02, 0x0a, 0x05,		// payload.text exceeds payload
+	};
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		Packet b;
+		b.fromMemory(bad,sizeof(bad));
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	Packet b;
+	assert(b.fromMemory(bad,sizeof(bad)) < 0);
+#endif
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
@@ -0,0 +1,130 @@
+#include "merge.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+static void merge(Node &n, const Node &u)
+{
+	// lazy field defaults references the data until it is accessed
+	static uint8_t buf[256];
+	ssize_t s = u.calcSize();
+	ssize_t x = u.toMemory(buf,sizeof(buf));
+	assert(x == s);
+	++NumToMem;
+	++NumFromMem;
+	ssize_t r = n.mergeFromMemory(buf,x);
+	assert(r == x);
+}
+
+
+int main(int argc, char **argv)
+{
+	Node n;
+	n.set_id(1);
+	n.set_name("node1");
+	n.mutable_limits()->set_low(1);
+	n.mutable_limits()->set_high(10);
+	n.mutable_limits()->add_tags("a");
+	n.mutable_limits()->add_tags("b");
+	n.add_log(1);
+	n.add_log(2);
+	n.add_peers(3);
+	n.add_peers(4);
+	n.add_history()->set_low(1);
+	n.mutable_defaults()->set_high(100);
+	n.mutable_defaults()->add_tags("x");
+	runcheck(n);
+
+	// update: a scalar, parts of embedded messages, and repeated fields
+	Node u;
+	u.set_id(2);
+	u.mutable_limits()->set_high(20);
+	u.mutable_limits()->add_tags("c");
+	u.add_log(3);
+	u.add_peers(5);
+	u.mutable_defaults()->set_low(7);
+	merge(n,u);
+
+	assert(n.id() == 2);
+	assert(n.has_name() && (n.name() == "node1"));
+	assert(n.limits().low() == 1);
+	assert(n.limits().high() == 20);
+	assert(n.limits().tags_size() == 1);
+	assert(n.limits().tags(0) == "c");
+	assert(n.log_size() == 3);
+	assert(n.log(2) == 3);
+	assert(n.peers_size() == 1);
+	assert(n.peers(0) == 5);
+	assert(n.history_size() == 1);
+	assert(!n.has_offset());
+	assert(n.defaults().low() == 7);
+	assert(n.defaults().high() == 100);
+	assert(n.defaults().tags_size() == 1);
+	runcheck(n);
+
+	// merging into an empty object equals parsing
+	Node e, p;
+	uint8_t buf[256];
+	n.calcSize();
+	ssize_t s = n.toMemory(buf,sizeof(buf));
+	assert(s > 0);
+	++NumToMem;
+	++NumFromMem;
+	assert(s == e.mergeFromMemory(buf,s));
+	++NumFromMem;
+	assert(s == p.fromMemory(buf,s));
+	assert(e == p);
+	assert(e == n);
+
+	// merging the same data again only appends to fields with merge=append
+	++NumFromMem;
+	assert(s == e.mergeFromMemory(buf,s));
+	assert(e.log_size() == 2*n.log_size());
+	assert(e.history_size() == 2*n.history_size());
+	assert(e.peers_size() == n.peers_size());
+	assert(e.limits() == n.limits());
+
+	// malformed data leaves the object untouched
+	Node m;
+	m.set_id(3);
+	m.add_peers(6);
+	m.mutable_limits()->add_tags("d");
+	m.calcSize();
+	s = m.toMemory(buf,sizeof(buf)-1);
+	assert(s > 0);
+	buf[s] = 0x80;	// incomplete tag
+	++NumToMem;
+	Node c(n);
+	++NumFromMem;
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		c.mergeFromMemory(buf,s+1);
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(c.mergeFromMemory(buf,s+1) < 0);
+#endif
+	assert(c.peers_size() == n.peers_size());
+	assert(c.limits().tags_size() == n.limits().tags_size());
+
+	// an embedded message must not exceed the data
+	uint8_t huge[] = { 0x1a, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0 };
+	memcpy(buf+s,huge,sizeof(huge));
+#if defined ON_ERROR_CANCEL
+	++NumFromMem;
+	assert(c.mergeFromMemory(buf,s+sizeof(huge)) < 0);
+	assert(c.peers_size() == n.peers_size());
+	assert(c.limits().tags_size() == n.limits().tags_size());
+#endif
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include "newer_n.h"
+#include "newer_o.h"
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+
+int main(int argc, char **argv)
+{
+	newer::Rec n;
+	n.set_a(0x12345678);
+	n.set_b("known");
+	n.set_c(4711);
+	n.add_d()->set_name("sub");
+	runcheck(n);
+	n.set_n1(0x123456789abcdefULL);
+	n.set_n2(std::string(300,'x').c_str());
+	for (unsigned i = 0; i < 100; ++i)
+		n.add_n3(i*i*i);
+	n.set_n4(-1234567890123LL);
+	n.set_n5(-0.5);
+	n.mutable_n6()->set_name("newer");
+	n.mutable_n6()->add_values(1000000);
+	runcheck(n);
+
+	// newer fields are skipped by the older version
+	size_t s = n.calcSize();
+	uint8_t buf[s*2];
+	ssize_t r = n.toMemory(buf,s);
+	assert(r == (ssize_t)s);
+	older::Rec o;
+	r = o.fromMemory(buf,s);
+	assert(r == (ssize_t)s);
+	assert(o.a() == n.a());
+	assert(o.b() == n.b());
+	assert(o.c() == n.c());
+	assert(o.d_size() == 1);
+	assert(o.d(0).name() == n.d(0).name());
+
+	// skipping stops at the first known field of the next message
+	memcpy(buf+s,buf,s);
+	older::Rec o2;
+	r = o2.fromMemory(buf,s*2);
+	assert(r == (ssize_t)s*2);
+	assert(o2.b() == n.b());
+	assert(o2.d_size() == 2);
+
+	// truncated data must not be read beyond its end
+	for (size_t l = 0; l < s; ++l) {
+		older::Rec t;
+		uint8_t *tb = (uint8_t *)malloc(l);
+		memcpy(tb,buf,l);
+#ifdef ON_ERROR_THROW
+		try {
+			t.fromMemory(tb,l);
+		} catch (int) {
+		}
+#else
+		t.fromMemory(tb,l);
+#endif
+		free(tb);
+	}
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
@@ -0,0 +1,59 @@
+#include <string>
+#include "nullterm.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+
+// every serializer writes the null terminator after the fields
+static void check_term(const Reading &m)
+{
+	size_t s = m.calcSize() + 1;
+	uint8_t buf[s+4];
+	memset(buf,0x5a,sizeof(buf));
+	assert((ssize_t)s == m.toMemory(buf,sizeof(buf)));
+	assert(buf[s-1] == 0);
+	assert(buf[s] == 0x5a);
+
+	uint8_t rev[s+4];
+	ssize_t o = m.toMemoryReverse(rev,sizeof(rev));
+	assert(o == 4);
+	assert(0 == memcmp(rev+o,buf,s));
+
+	BufferedSinkMem<16> ms;
+	m.toSink(ms);
+	ms.flushBuffer();
+	assert(ms.getSize() == (ssize_t)s);
+	assert(0 == memcmp(ms.getBuffer(),buf,s));
+
+#ifdef HAVE_TO_STRING
+	stringtype str;
+	m.toString(str);
+	assert(str.size() == s);
+	assert(0 == memcmp(str.data(),buf,s));
+#endif
+
+	// parsing stops in front of the terminator
+	buf[s] = 0x08;
+	Reading r;
+	assert((ssize_t)s-1 == r.fromMemory(buf,s+1));
+	assert(r == m);
+}
+
+
+int main(int argc, char **argv)
+{
+	Reading m;
+	check_term(m);
+	m.set_id(7);
+	m.set_value(-300);
+	check_term(m);
+	m.set_unit("mV");
+	for (int i = 0; i < 20; ++i)
+		m.add_raw(i*0x101);
+	check_term(m);
+	printf("%s: done\n",argv[0]);
+	return 0;
+}
@@ -29,11 +29,28 @@ uint8_t test_f64_err_2[] = {
 };
 
 
+uint8_t test_u32_err_1[] = {
+	0x3a, 2, 0x80, 0x80
+};
+
+uint8_t test_i16a_err_1[] = {
+	0x4a, 5, 1,2,3,4,5
+};
+
+// unpacked elements of packed fields, mixed with packed encoding
+uint8_t test_unpacked[] = {
+	0x0c, 0x34, 0x12,		// F16 0x1234
+	0x38, 0x05,			// U32 5
+	0x3a, 0x02, 0x06, 0x07,		// U32 packed 6,7
+	0x38, 0x08,			// U32 8
+	0x40, 0x03,			// S64 -2
+};
 
 
 int main()
 {
 	M m;
+	ssize_t r;
 	runcheck(m);
 	m.add_F16(0);
 	m.add_F16(UINT16_MAX);
@@ -44,8 +61,48 @@ int main()
 	m.add_F64(0);
 	m.add_F64(UINT64_MAX);
 	runcheck(m);
+	for (int i = 0; i < 1000; ++i) {
+		m.add_Flt(i*0.5f);
+		m.add_Dbl(i*-0.25);
+	}
+	runcheck(m);
+	for (int i = 0; i < 4; ++i)
+		m.add_S32A(i-2);
+	runcheck(m);
+	for (int i = 0; i < 10000; ++i) {
+		m.add_U32(i*i);
+		m.add_S64(-((int64_t)i << 20));
+	}
+	runcheck(m);
+	m.add_I16A(INT16_MIN);
+	m.add_I16A(INT16_MAX);
+	runcheck(m);
+
+	// merging appends to the elements of the first copy
+	size_t s = m.calcSize();
+	uint8_t buf[s*2];
+	r = m.toMemory(buf,s);
+	assert(r == (ssize_t)s);
+	memcpy(buf+s,buf,s);
+	M m2;
+	r = m2.fromMemory(buf,s*2);
+	assert(r == (ssize_t)s*2);
+	assert(m2.Flt_size() == 2000);
+	assert(m2.Flt(1999) == m.Flt(999));
+	assert(m2.Dbl(1000) == m.Dbl(0));
+	assert(m2.S32A_size() == 8);
+	assert(m2.S32A(7) == 1);
+	assert(m2.U32_size() == 20000);
+	assert(m2.U32(19999) == m.U32(9999));
+	assert(m2.S64(10000) == m.S64(0));
+	assert(m2.I16A_size() == 4);
+	assert(m2.I16A(2) == INT16_MIN);
+
+	// array capacity exceeded
+	r = m2.fromMemory(buf,s);
+	assert(r < 0);
+
 	m.clear();
-	ssize_t r;
 	r = m.fromMemory(test_f16_err_1,sizeof(test_f16_err_1));
 	assert(r < 0);
 	r = m.fromMemory(test_f32_err_1,sizeof(test_f32_err_1));
@@ -58,4 +115,20 @@ int main()
 	assert(r < 0);
 	r = m.fromMemory(test_f64_err_2,sizeof(test_f64_err_2));
 	assert(r < 0);
+	r = m.fromMemory(test_u32_err_1,sizeof(test_u32_err_1));
+	assert(r < 0);
+	r = m.fromMemory(test_i16a_err_1,sizeof(test_i16a_err_1));
+	assert(r < 0);
+
+	m.clear();
+	r = m.fromMemory(test_unpacked,sizeof(test_unpacked));
+	assert(r == sizeof(test_unpacked));
+	assert(m.F16_size() == 1);
+	assert(m.F16(0) == 0x1234);
+	assert(m.U32_size() == 4);
+	for (unsigned i = 0; i < 4; ++i)
+		assert(m.U32(i) == i+5);
+	assert(m.S64_size() == 1);
+	assert(m.S64(0) == -2);
+	runcheck(m);
 }
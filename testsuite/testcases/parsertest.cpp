@@ -0,0 +1,69 @@
+#include "parser.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+static void fill(Group *g, int n)
+{
+	for (int i = 0; i < n; ++i) {
+		Item *it = g->add_items();
+		it->set_name("item");
+		it->set_value(-i*1000);
+	}
+	g->mutable_best()->set_name("best");
+	g->mutable_best()->set_value(n);
+}
+
+
+int main(int argc, char **argv)
+{
+	Record r;
+	r.set_id(0x12345678);
+	fill(r.mutable_group(),3);
+	for (unsigned i = 0; i < 50; ++i)
+		r.add_nums(i*i*i);
+	r.mutable_data()->assign(300,'x');
+	fill(r.add_groups(),0);
+	fill(r.add_groups(),2);
+	r.set_ratio(0.25);
+	runcheck(r.group());
+
+	size_t s = r.calcSize();
+	uint8_t buf[s];
+	ssize_t n = r.toMemory(buf,s);
+	assert(n == (ssize_t)s);
+
+	// feed the data in chunks of all sizes, each from a scratch buffer
+	// that is overwritten afterwards
+	for (size_t c = 1; c <= s; ++c) {
+		Record x;
+		Record::Parser p(x);
+		uint8_t chunk[c];
+		for (size_t o = 0; o < s; o += c) {
+			size_t l = (s-o) < c ? s-o : c;
+			memcpy(chunk,buf+o,l);
+			n = p.feed(chunk,l);
+			assert(n == (ssize_t)l);
+			memset(chunk,0xff,l);
+		}
+		assert(p.complete());
+		assert(x == r);
+	}
+
+	// incomplete input
+	Record y;
+	Record::Parser p(y);
+	n = p.feed(buf,s-1);
+	assert(n == (ssize_t)s-1);
+	assert(!p.complete());
+	n = p.feed(buf+s-1,1);
+	assert(n == 1);
+	assert(p.complete());
+	assert(y == r);
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
@@ -0,0 +1,97 @@
+#include "projection.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+int main(int argc, char **argv)
+{
+	Record r;
+	r.set_id(4711);
+	r.set_name("record");
+	r.set_f8(0x12);
+	r.set_f16(0x1234);
+	r.set_f32(0x12345678);
+	r.set_ratio(-0.5);
+	r.mutable_inner()->set_name("inner");
+	r.mutable_inner()->set_value(-1000);
+	for (unsigned i = 0; i < 20; ++i)
+		r.add_nums(i*i*i*i);
+	r.add_inners()->set_value(1);
+	r.add_inners()->set_name("second");
+	r.set_big(-1234567890123LL);
+	runcheck(r);
+
+	size_t s = r.calcSize();
+	uint8_t buf[s];
+	ssize_t n = r.toMemory(buf,s);
+	assert(n == (ssize_t)s);
+
+	// empty mask decodes nothing
+	Record x;
+	n = x.fromMemory(buf,s,FieldMask());
+	assert(n == (ssize_t)s);
+	assert(x == Record());
+
+	// all fields
+	Record y;
+	n = y.fromMemory(buf,s,FieldMask{1,2,3,4,5,6,7,8,9,130});
+	assert(n == (ssize_t)s);
+	assert(y == r);
+
+	// single fields and pairs of fields
+	Record z;
+	n = z.fromMemory(buf,s,FieldMask{2,130});
+	assert(n == (ssize_t)s);
+	assert(!z.has_id());
+	assert(z.name() == r.name());
+	assert(!z.has_f32());
+	assert(!z.has_inner());
+	assert(z.nums_size() == 0);
+	assert(z.inners_size() == 0);
+	assert(z.big() == r.big());
+
+	Record w;
+	n = w.fromMemory(buf,s,FieldMask{4,7,8});
+	assert(n == (ssize_t)s);
+	assert(!w.has_name());
+	assert(!w.has_f8());
+	assert(w.f16() == r.f16());
+	assert(!w.has_ratio());
+	assert(w.inner() == r.inner());
+	assert(w.nums_size() == r.nums_size());
+	assert(w.nums(19) == r.nums(19));
+	assert(!w.has_big());
+
+	FieldMask fm;
+	fm.set(9);
+	fm.set(1);
+	fm.clear(1);
+	Record v;
+	n = v.fromMemory(buf,s,fm);
+	assert(n == (ssize_t)s);
+	assert(!v.has_id());
+	assert(v.inners_size() == 2);
+	assert(v.inners(1).name() == "second");
+
+	// truncated data is detected
+	for (size_t l = 0; l < s; ++l) {
+		Record t;
+		ssize_t n = t.fromMemory(buf,l,fm);
+		assert(n <= (ssize_t)l);
+	}
+
+	// a skipped field must not exceed the data
+	uint8_t huge[] = { 0x1a, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 0 };
+	for (size_t l = 1; l <= sizeof(huge); ++l) {
+		Record t;
+#if defined ON_ERROR_CANCEL
+		assert(t.fromMemory(huge,l,fm) < 0);
+#endif
+	}
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
@@ -0,0 +1,301 @@
+#define WITH_SINK_STRING
+#define WITH_SINK_FD
+#include <string>
+#include "refser.h"
+
+#include <cfloat>
+#include <stdio.h>
+#include <iostream>
+#include <math.h>
+#include <type_traits>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+#ifdef SUBCLASSES
+#define TestBench_KVPair TestBench::KVPair
+#endif
+
+static unsigned NumCalls = 0;
+static size_t MaxBlock = 0;
+
+
+void wirewrite(const uint8_t *d, size_t n)
+{
+	assert(n != 0);
+	++NumCalls;
+	if (n > MaxBlock)
+		MaxBlock = n;
+	Wire.append((const char *)d,n);
+}
+
+
+// serialize back to front
+static void check_reverse(const TestBench &tb)
+{
+#ifdef HAVE_PADDED_MESSAGE_SIZE
+	// length of embedded messages is not padded
+	bool identical = false;
+#else
+	bool identical = true;
+#endif
+	ssize_t rs = 0;
+	cmptomem(tb,[&tb,&rs](string &out) {
+		ssize_t s = tb.calcSize();
+		uint8_t *b = (uint8_t *) malloc(s+16);
+		++NumToMem;
+		ssize_t o = tb.toMemoryReverse(b,s+16);
+		assert((o >= 16) && (o <= s+16));
+		rs = s + 16 - o;
+		out.assign((const char *)b+o,rs);
+		free(b);
+	},identical);
+
+	// too small buffers must be rejected
+	for (ssize_t l = 0; l < rs; ++l) {
+		uint8_t *b = (uint8_t *) malloc(l);
+#if defined ON_ERROR_THROW
+		bool ok = false;
+		try {
+			tb.toMemoryReverse(b,l);
+		} catch (int x) {
+			++NumErrThrow;
+			ok = (x < 0);
+		}
+		assert(ok);
+#elif defined ON_ERROR_CANCEL
+		assert(tb.toMemoryReverse(b,l) < 0);
+#endif
+		free(b);
+	}
+}
+
+
+// serialize without bounds checks
+template <class M>
+static void check_unchecked(const M &m)
+{
+	cmptomem(m,[&m](string &out) {
+		size_t s = m.calcSize();
+		uint8_t *b = (uint8_t *) malloc(s+1);
+		b[s] = 0x5a;
+		++NumToMem;
+		size_t n = m.toMemoryUnchecked(b);
+		assert(b[s] == 0x5a);
+		out.assign((const char *)b,n);
+		free(b);
+	});
+}
+
+
+// buffered sinks refer to their own buffer and must not be copied
+static_assert(!is_copy_constructible<BufferedSinkMem<16>>::value,"copyable sink");
+static_assert(!is_copy_assignable<BufferedSinkString<16>>::value,"copyable sink");
+
+
+// serialize with the buffered sinks
+template <size_t N>
+static void check_sinks(const TestBench &tb)
+{
+	cmptomem(tb,[&tb](string &out) {
+		BufferedSinkMem<N> ms;
+		++NumToSink;
+		tb.toSink(ms);
+		out.assign((const char *)ms.getBuffer(),ms.getSize());
+	});
+	cmptomem(tb,[&tb](string &out) {
+		BufferedSinkString<N> ss(out);
+		++NumToSink;
+		tb.toSink(ss);
+	});
+	cmptomem(tb,[&tb](string &out) {
+		int fds[2];
+		int r = pipe(fds);
+		assert(r == 0);
+		{
+			BufferedSinkFd<N> fs(fds[1]);
+			++NumToSink;
+			tb.toSink(fs);
+			fs.flushBuffer();
+			assert(fs.getError() == 0);
+		}
+		close(fds[1]);
+		char tmp[512];
+		while ((r = read(fds[0],tmp,sizeof(tmp))) > 0)
+			out.append(tmp,r);
+		close(fds[0]);
+	});
+}
+
+
+// toString appends to the string
+static void check_string(const TestBench &tb)
+{
+#ifdef HAVE_TO_STRING
+	cmptomem(tb,[&tb](string &out) {
+		stringtype str("prefix");
+		tb.toString(str);
+		assert(0 == memcmp(str.data(),"prefix",6));
+		out.assign(str.data()+6,str.size()-6);
+	});
+#endif
+}
+
+
+// serialize block-wise to function wirewrite
+static void check_blocks(const TestBench &tb)
+{
+	cmptomem(tb,[&tb](string &out) {
+		Wire.clear();
+		NumCalls = 0;
+		MaxBlock = 0;
+		++NumToWire;
+		tb.toWire();
+		out.assign((const char *)Wire.data(),Wire.size());
+	});
+	assert(NumCalls <= tb.calcSize());
+}
+
+
+// serialize to an iovec array
+static void check_iovec(const TestBench &tb, size_t threshold, size_t large)
+{
+	cmptomem(tb,[&tb,threshold,large](string &out) {
+		struct iovec iov[256];
+		uint8_t arena[8192];
+		IovecBuilder v(iov,sizeof(iov)/sizeof(iov[0]),arena,sizeof(arena),threshold);
+		ssize_t n = tb.toIovec(v);
+		assert(n == (ssize_t)v.getSize());
+		bool ref = false;
+		for (unsigned i = 0; i < v.numIovec(); ++i) {
+			const struct iovec &e = v.getIovec()[i];
+			out.append((const char *)e.iov_base,e.iov_len);
+			if (((uint8_t *)e.iov_base < arena) || ((uint8_t *)e.iov_base >= arena+sizeof(arena)))
+				ref |= (e.iov_len == large);
+		}
+		// large payloads must be referenced in place
+		assert(ref || (large == 0));
+	});
+}
+
+
+// running out of iovec entries must be reported
+static void check_iovec_overflow(const TestBench &tb)
+{
+	struct iovec iov[2];
+	uint8_t arena[1024];
+	IovecBuilder v(iov,sizeof(iov)/sizeof(iov[0]),arena,sizeof(arena),1);
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		tb.toIovec(v);
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(tb.toIovec(v) < 0);
+#endif
+}
+
+
+static void check_all(const TestBench &tb, size_t large = 0)
+{
+	check_reverse(tb);
+	check_unchecked(tb);
+	check_sinks<10>(tb);
+	check_sinks<16>(tb);
+	check_sinks<256>(tb);
+	check_string(tb);
+	check_blocks(tb);
+	check_iovec(tb,64,large);
+	check_iovec(tb,1,large);
+	check_iovec(tb,1024,large);
+	runcheck(tb);
+}
+
+
+int main(int argc, char **argv)
+{
+	uint8_t data[] = {5,4,3,2,1,0,1,2,3,4,5};
+	TestBench tb;
+	check_all(tb);
+
+	tb.set_VI32(-123456);
+	tb.set_SVI32(-123456);
+	tb.set_VI64(1234567890);
+	tb.set_SVI64(-1234567890);
+	tb.set_RDouble(M_PI);
+	tb.set_B1(true);
+	tb.set_FI8(88);
+	tb.set_FI16(0xffff);
+	tb.set_FI32(0xffffffff);
+	tb.set_FI64(64646464646464);
+	tb.set_Float(M_PI_2);
+	tb.set_I8(INT8_MIN);
+	tb.set_SI16(INT16_MIN);
+	tb.set_I32(-1);
+	tb.set_SI64(INT64_MAX);
+	tb.set_BYTESR(data,sizeof(data));
+	tb.set_SSR("required string");
+	tb.set_SCR("required string class");
+	tb.set_SPR("required char *");
+	tb.mutable_PackedMsg()->set_U8(33);
+	check_all(tb);
+
+	tb.set_STR("test string");
+	for (int x = 0; x < 20; ++x) {
+		tb.add_STRV(string(x*3,'s').c_str());
+		tb.add_BYTESV(string(x,'b'));
+		tb.add_SSV(string(x*5,'v').c_str());
+		tb.add_PackedF8Vector(x*x);
+		tb.add_PackedF16Vector(x*1000);
+		tb.add_PackedF32Vector(x*0x1000001);
+		tb.add_PackedF64Vector(x*0x100000001ULL);
+		tb.add_PackedS16Vector(x&1 ? -x*x : x*x);
+		tb.add_PackedS64Vector(x&1 ? -x*1000000LL : x*x);
+		tb.add_UnpackedF16Vector(x);
+		tb.add_FloatV(x/3.0);
+		tb.add_DoubleV(x/7.0);
+		Packable *p = tb.add_PackedMsgV();
+		p->set_U8(x);
+		p->set_I8(-x);
+		tb.add_FPackedMsgV()->set_F16(x*x);
+	}
+	tb.add_GenericEnumV(ge_1);
+	tb.add_GenericEnumV(ge_4);
+	tb.add_GenericEnumPV(ge_2);
+	tb.add_GenericEnumPV(ge_8);
+	TestBench_KVPair kvp;
+	kvp.set_key("key0");
+	kvp.set_value("value0");
+	tb.set_kvpair1(kvp);
+	*tb.add_kvpairs() = kvp;
+	kvp.set_key("key1");
+	kvp.set_value("value1");
+	*tb.add_kvpairs() = kvp;
+	check_all(tb);
+	check_iovec_overflow(tb);
+
+	// large payloads are passed on without copying
+	string blob(3000,'b');
+	tb.set_BYTESO(blob);
+	check_all(tb,blob.size());
+	check_blocks(tb);
+	assert(MaxBlock == blob.size());
+
+	// a buffer of the maximum size takes the unchecked path of toMemory
+	check_unchecked(tb.PackedMsg());
+	uint8_t buf[256];
+	ssize_t n = tb.PackedMsg().toMemory(buf,sizeof(buf));
+	assert(n == (ssize_t)tb.PackedMsg().calcSize());
+	Packable p;
+	++NumFromMem;
+	assert(n == p.fromMemory(buf,n));
+	assert(p == tb.PackedMsg());
+
+	printf("%s: %s\n",argv[0],testcnt());
+}
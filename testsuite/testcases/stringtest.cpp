@@ -3,6 +3,8 @@
 #include "runcheck.h"
 #include "runcheck.cpp"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
@@ -14,8 +16,45 @@ int main(int argc, const char *argv[])
 	st.set_s1("s1");
 	st.set_s2("s2");
 	st.set_s3("s3");
+	st.set_s4("s4");
+	st.set_b5("b5");
 	//st.toASCII(cout);
 	runcheck(st);
 
+	// setByName must not refer to the value after returning
+	char *tmp = strdup("temporary");
+	assert(st.setByName("s1",tmp) > 0);
+#if defined ON_ERROR_THROW
+	bool ok = false;
+	try {
+		st.setByName("s4",tmp);
+	} catch (int x) {
+		++NumErrThrow;
+		ok = (x < 0);
+	}
+	assert(ok);
+#elif defined ON_ERROR_CANCEL
+	assert(st.setByName("s4",tmp) < 0);
+#endif
+	memset(tmp,'x',strlen(tmp));
+	free(tmp);
+	assert(st.s1() == "temporary");
+	assert(st.s4() == "s4");
+	runcheck(st);
+
+	// views refer to the payload within the parsed buffer
+	st.set_b5(BufView("b\0v",3));
+	size_t s = st.calcSize();
+	uint8_t buf[s];
+	assert((ssize_t)s == st.toMemory(buf,s));
+	StringTypes v;
+	++NumFromMem;
+	assert((ssize_t)s == v.fromMemory(buf,s));
+	assert(v == st);
+	const char *e = (const char *)buf + s;
+	assert((v.s4().data() >= (const char *)buf) && (v.s4().data()+v.s4().size() <= e));
+	assert((v.b5().data() >= (const char *)buf) && (v.b5().data()+v.b5().size() <= e));
+	assert(0 == memcmp(v.b5().data(),"b\0v",3));
+
 	printf("%s: %s\n",argv[0],testcnt());
 }
@@ -85,4 +85,23 @@ int main()
 	x = m.setByName("RB[1]","true");
 	assert(x > 0);
 	assert(m.RB(1) == true);
+
+	// names of equal length are told apart by a single character
+	x = m.setByName("RS[0]","other");
+	assert(x > 0);
+	assert(m.RS(0) == "other");
+	assert(m.RD(0) == -1.5);
+
+	x = m.setByName("X","1");
+	assert(x < 0);
+	x = m.setByName("RX[0]","1");
+	assert(x < 0);
+	x = m.setByName("Bx","1");
+	assert(x < 0);
+	x = m.setByName("pair[0].key","k");
+	assert(x < 0);
+	x = m.setByName("pairs[0].kex","k");
+	assert(x < 0);
+	x = m.setByName("","1");
+	assert(x < 0);
 }
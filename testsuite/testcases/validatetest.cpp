@@ -0,0 +1,134 @@
+#include "validate.h"
+#include <stdio.h>
+#include <iostream>
+
+using namespace std;
+
+#include "runcheck.h"
+#include "runcheck.cpp"
+
+// inner without required field id
+uint8_t inner_noid[] = {
+	0x1a, 0x00
+};
+
+uint8_t inner_ok[] = {
+	0x1a, 0x02, 0x08, 0x05
+};
+
+// unknown field id 15
+uint8_t unknown_field[] = {
+	0x78, 0x01
+};
+
+// packed fixed16 with odd length
+uint8_t shorts_odd[] = {
+	0x2a, 0x03, 1, 2, 3
+};
+
+// packed varint that is not terminated
+uint8_t values_open[] = {
+	0x22, 0x02, 0x01, 0x81, 0x01
+};
+
+// packed fields in unpacked encoding
+uint8_t unpacked[] = {
+	0x20, 0x05, 0x2c, 0x34, 0x12, 0x20, 0x06
+};
+
+// C string without terminating null byte
+uint8_t label_open[] = {
+	0x42, 0x02, 'a', 'b'
+};
+
+// C string of length 0
+uint8_t label_empty[] = {
+	0x42, 0x00
+};
+
+uint8_t label_ok[] = {
+	0x42, 0x03, 'a', 'b', 0
+};
+
+
+int main(int argc, char **argv)
+{
+	Record r;
+	ssize_t n;
+	n = Record::validate(0,0);
+	assert(n == 0);
+	r.set_f32(0x12345678);
+	r.set_ratio(-0.5);
+	r.mutable_inner()->set_id(17);
+	r.mutable_inner()->set_name("inner");
+	for (int i = 0; i < 50; ++i) {
+		r.add_values(i*i*(i&1 ? -1 : 1));
+		r.add_shorts(i);
+	}
+	r.add_inners()->set_id(1);
+	r.add_inners()->set_name("second");
+	r.set_data("data");
+	r.set_label("label");
+	r.set_big(-1234567890123LL);
+	runcheck(r);
+
+	size_t s = r.calcSize();
+	uint8_t buf[s];
+	n = r.toMemory(buf,s);
+	assert(n == (ssize_t)s);
+	n = Record::validate(buf,s);
+	assert(n == (ssize_t)s);
+
+	// data accepted by validate is also accepted by fromMemory
+	for (size_t l = 0; l < s; ++l) {
+		if (Record::validate(buf,l) == (ssize_t)l) {
+			Record t;
+			n = t.fromMemory(buf,l);
+			assert(n == (ssize_t)l);
+		}
+	}
+	for (size_t x = 0; x < s; ++x) {
+		uint8_t c = buf[x];
+		for (unsigned v = 0; v < 256; v += 7) {
+			buf[x] = v;
+			if (Record::validate(buf,s) == (ssize_t)s) {
+				Record t;
+				n = t.fromMemory(buf,s);
+				assert(n == (ssize_t)s);
+			}
+		}
+		buf[x] = c;
+	}
+
+	n = Record::validate(inner_noid,sizeof(inner_noid));
+	assert(n < 0);
+	n = Record::validate(inner_ok,sizeof(inner_ok));
+	assert(n == sizeof(inner_ok));
+	n = Record::validate(unknown_field,sizeof(unknown_field));
+	assert(n < 0);
+	n = Record::validate(shorts_odd,sizeof(shorts_odd));
+	assert(n < 0);
+	n = Record::validate(values_open,sizeof(values_open));
+	assert(n < 0);
+	n = Record::validate(unpacked,sizeof(unpacked));
+	assert(n == sizeof(unpacked));
+	Record u;
+	n = u.fromMemory(unpacked,sizeof(unpacked));
+	assert(n == sizeof(unpacked));
+	assert(u.values_size() == 2);
+	assert(u.values(0) == -3);
+	assert(u.values(1) == 3);
+	assert(u.shorts_size() == 1);
+	n = Record::validate(label_open,sizeof(label_open));
+	assert(n < 0);
+	n = Record::validate(label_empty,sizeof(label_empty));
+	assert(n < 0);
+	n = Record::validate(label_ok,sizeof(label_ok));
+	assert(n == sizeof(label_ok));
+	n = Inner::validate(inner_ok+2,2);
+	assert(n == 2);
+	n = Inner::validate(inner_ok+2,0);
+	assert(n < 0);
+
+	printf("%s: %s\n",argv[0],testcnt());
+}